@@ -0,0 +1,76 @@
+#pragma once
+#include "LowLevel/Compute.h"
+#include "Shader.h"
+
+namespace JGFX{
+	namespace Barrier{
+		using namespace LLJGFX::Barrier;
+	}
+
+	class StorageBuffer{
+	private:
+		LLJGFX::StorageBuffer::Handle handle_ = { nullptr };
+	public:
+		inline StorageBuffer& SetData(const void* data, size_t size, size_t offset = 0)
+			{ LLJGFX::StorageBuffer::SetData(handle_, data, size, offset); return *this; }
+		template<typename T> inline StorageBuffer& SetData(const std::vector<T>& data, size_t offset = 0)
+			{ return SetData(data.data(), data.size() * sizeof(T), offset); }
+		template<typename Layout, typename... Ts> inline StorageBuffer& SetElement(size_t index, const Ts&... values)
+			{ LLJGFX::StorageBuffer::SetElement<Layout>(handle_, index, values...); return *this; }
+
+		inline void GetData(void* dest, size_t size, size_t offset = 0) const
+			{ LLJGFX::StorageBuffer::GetData(handle_, dest, size, offset); }
+		template<typename T> inline std::vector<T> GetData() const {
+			std::vector<T> res(size() / sizeof(T));
+			GetData(res.data(), res.size() * sizeof(T));
+			return res;
+		}
+
+		inline void Bind(uint32 binding_point) const { LLJGFX::StorageBuffer::Bind(handle_, binding_point); }
+
+		//To draw from it, see LLJGFX::StorageBuffer::GetVBuff()
+		inline LLJGFX::VBuff::Handle vbuff() const { return LLJGFX::StorageBuffer::GetVBuff(handle_); }
+		inline size_t size() const { return LLJGFX::StorageBuffer::GetSize(handle_); }
+		inline LLJGFX::StorageBuffer::Handle handle() const { return handle_; }
+
+		inline StorageBuffer(size_t size, const void* data = nullptr) { handle_ = LLJGFX::StorageBuffer::Make(size, data); }
+		template<typename T> inline StorageBuffer(const std::vector<T>& data)
+			{ handle_ = LLJGFX::StorageBuffer::Make(data.size() * sizeof(T), data.data()); }
+
+		StorageBuffer(const StorageBuffer&) = delete;
+		StorageBuffer& operator=(const StorageBuffer&) = delete;
+
+		inline StorageBuffer& operator=(StorageBuffer&& cpy) noexcept {
+			this->~StorageBuffer();
+			std::swap(handle_, cpy.handle_);
+			return *this;
+		}
+		inline StorageBuffer(StorageBuffer&& cpy) noexcept { operator=(std::move(cpy)); }
+
+		inline ~StorageBuffer() { LLJGFX::StorageBuffer::Delete(handle_); handle_ = { nullptr }; }
+	};
+
+	//A ShaderProgram with a single compute stage, the uniforms are set the same way
+	class ComputeProgram : public ShaderProgram{
+	public:
+		void Compile(const std::string& compute_src) {
+			BeforeModification();
+			LLJGFX::ShaderProgram::CompileCompute(handle(), compute_src);
+		}
+		void CompileAsync(const std::string& compute_src) {
+			BeforeModification();
+			LLJGFX::ShaderProgram::CompileCompute(handle(), compute_src, true);
+		}
+
+		inline void Dispatch(uint32 x, uint32 y = 1, uint32 z = 1) const { LLJGFX::Compute::Dispatch(handle(), x, y, z); }
+		inline void DispatchIndirect(const StorageBuffer& args, size_t offset = 0) const
+			{ LLJGFX::Compute::DispatchIndirect(handle(), args.handle(), offset); }
+
+		inline ComputeProgram() = default;
+		inline ComputeProgram(const std::string& compute_src) { Compile(compute_src); }
+	};
+
+	namespace Compute{
+		using namespace LLJGFX::Compute;
+	}
+}
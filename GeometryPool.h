@@ -0,0 +1,41 @@
+#pragma once
+#include "LowLevel/GeometryPool.h"
+
+namespace JGFX{
+	using PoolMesh = LLJGFX::GeoPool::Mesh;
+	using GeometryPoolStats = LLJGFX::GeoPool::Stats;
+
+	class GeometryPool{
+	private:
+		LLJGFX::GeoPool::Handle handle_ = { nullptr };
+	public:
+		template <typename T> inline PoolMesh Add(const std::vector<T>& vertices, const std::vector<LLJGFX::HandleType>& indices)
+			{ return LLJGFX::GeoPool::AddMesh(handle_, vertices, indices); }
+		template <typename T> inline PoolMesh Add(const T* vertices, size_t vertex_count,
+		                                          const LLJGFX::HandleType* indices, size_t index_count)
+			{ return LLJGFX::GeoPool::AddMesh(handle_, vertices, vertex_count, indices, index_count); }
+		inline GeometryPool& Remove(PoolMesh mesh) { LLJGFX::GeoPool::RemoveMesh(mesh); return *this; }
+
+		inline GeometryPool& Defragment() { LLJGFX::GeoPool::Defragment(handle_); return *this; }
+
+		inline GeometryPoolStats stats() const { return LLJGFX::GeoPool::GetStats(handle_); }
+		inline LLJGFX::VRef::Handle vref() const { return LLJGFX::GeoPool::GetVRef(handle_); }
+		inline LLJGFX::GeoPool::Handle handle() const { return handle_; }
+
+		inline GeometryPool(const VertexLayout& layout, size_t vertex_capacity = 65536, size_t index_capacity = 65536 * 3)
+			{ handle_ = LLJGFX::GeoPool::Make(layout, vertex_capacity, index_capacity); }
+
+		//The pool owns the GPU storage of all its meshes, so copying it would mean copying every mesh handle too
+		GeometryPool(const GeometryPool&) = delete;
+		GeometryPool& operator=(const GeometryPool&) = delete;
+
+		inline GeometryPool& operator=(GeometryPool&& cpy) noexcept {
+			this->~GeometryPool();
+			std::swap(handle_, cpy.handle_);
+			return *this;
+		}
+		inline GeometryPool(GeometryPool&& cpy) noexcept { operator=(std::move(cpy)); }
+
+		inline ~GeometryPool() { LLJGFX::GeoPool::Delete(handle_); handle_ = { nullptr }; }
+	};
+}
@@ -10,8 +10,20 @@
 #include "Mesh.hpp"
 #include "Texture.h"
 #include "Window.h"
+#include "GeometryPool.h"
+#include "PipelineState.h"
+#include "UniformBuffer.h"
+#include "ShaderFamily.h"
+#include "Compute.h"
+#include "TransformFeedback.h"
+#include "TextureUpload.h"
+#include "Readback.h"
 
 #include "LowLevel/Draw.h"
+#include "LowLevel/DrawList.h"
+#include "LowLevel/CommandBuffer.h"
+#include "LowLevel/RenderThread.h"
+#include "LowLevel/Instancing.h"
 
 
 bool InitFuncPrimary(){
@@ -27,7 +39,11 @@ bool InitFunc() {
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 	LLJGFX::Internal::InitializeTextures();
+	LLJGFX::Internal::InitializeTextureUploads();
 	LLJGFX::Internal::InitializeShaders();
+	LLJGFX::Internal::InitializeUniformBuffers();
+	LLJGFX::Internal::InitializeCompute();
+	LLJGFX::Internal::InitializeTransformFeedback();
 	LLJGFX::Internal::InitializeDraw();
 	return true;
 }
@@ -46,27 +62,224 @@ namespace JGFX {
 			int32 slot_id = 0;
 			TxtFnArg txt = {};
 		};
+		//Converts in place, a braced list of bindings doesn't touch the heap
+		struct TextureBindingList : public LLJGFX::TextureBindings{
+			TextureBindingList() = default;
+			TextureBindingList(std::initializer_list<TextureSlotBinding> bindings)
+				{ for(const TextureSlotBinding& i : bindings) push_back({i.slot_id, i.txt}); }
+			TextureBindingList(const std::vector<TextureSlotBinding>& bindings)
+				{ for(const TextureSlotBinding& i : bindings) push_back({i.slot_id, i.txt}); }
+		};
 	}
 
 	inline void Draw(Internal::VRefHandleWrapper vref,
-	                 const std::vector<Internal::TextureSlotBinding>& txt = {},
-	                 Internal::ShHandleArgumentWrapper prg = NULL_PRG, size_t instances = 1){
-
-		std::vector<LLJGFX::TmpTextureSlotBinding> tmp(txt.size());
-		memcpy(tmp.data(), txt.data(), txt.size() * sizeof(Internal::TextureSlotBinding));
-		LLJGFX::Draw(vref.handle_, tmp, prg, instances);
-	}
+	                 const Internal::TextureBindingList& txt = {},
+	                 Internal::ShHandleArgumentWrapper prg = NULL_PRG, size_t instances = 1)
+		{ LLJGFX::Draw(vref.handle_, txt, prg, instances); }
 	inline void Draw(Internal::VRefHandleWrapper vref,
 	                 Internal::TxtFnArg txt = NULL_TXT,
 	                 Internal::ShHandleArgumentWrapper prg = NULL_PRG, size_t instances = 1){
 		LLJGFX::Draw(vref.handle_, {{0, txt}}, prg, instances);
 	}
 
+	inline void ValidateVertexInput(Internal::ShHandleArgumentWrapper prg, Internal::VRefHandleWrapper vref)
+		{ LLJGFX::ValidateVertexInput(prg, vref.handle_); }
+
+	using LLJGFX::DrawRange;
+	using LLJGFX::DrawFast;
+	namespace DrawFlags{
+		using namespace LLJGFX::DrawFlags;
+	}
+
+	inline void Draw(Internal::VRefHandleWrapper vref, DrawRange range,
+	                 const Internal::TextureBindingList& txt = {},
+	                 Internal::ShHandleArgumentWrapper prg = NULL_PRG, size_t instances = 1){
+		LLJGFX::Draw(vref.handle_, range, txt, prg, instances);
+	}
+	//The program comes from the pipeline state
+	inline void Draw(const PipelineState& pipeline, Internal::VRefHandleWrapper vref,
+	                 const Internal::TextureBindingList& txt = {},
+	                 DrawRange range = {}, size_t instances = 1){
+		LLJGFX::Draw(pipeline.handle(), vref.handle_, txt, range, instances);
+	}
+	inline void Draw(PoolMesh mesh, const Internal::TextureBindingList& txt = {},
+	                 Internal::ShHandleArgumentWrapper prg = NULL_PRG, size_t instances = 1){
+		LLJGFX::Draw(mesh, txt, prg, instances);
+	}
+	inline void MultiDraw(const std::vector<PoolMesh>& meshes, const Internal::TextureBindingList& txt = {},
+	                      Internal::ShHandleArgumentWrapper prg = NULL_PRG){
+		LLJGFX::MultiDraw(meshes, txt, prg);
+	}
+	inline void MultiDraw(Internal::VRefHandleWrapper vref, const std::vector<DrawRange>& ranges,
+	                      const Internal::TextureBindingList& txt = {},
+	                      Internal::ShHandleArgumentWrapper prg = NULL_PRG){
+		LLJGFX::MultiDraw(vref.handle_, ranges, txt, prg);
+	}
+
+	//Collects draws and submits them sorted by state(and by depth), see LLJGFX::DrawList::MakeKey()
+	class DrawList{
+	private:
+		LLJGFX::DrawList::Handle handle_ = { nullptr };
+
+		static LLJGFX::TmpRT MakeRT(Internal::VRefHandleWrapper vref, const Internal::TextureBindingList& txt,
+		                            Internal::ShHandleArgumentWrapper prg, size_t instances)
+			{ return { vref.handle_, txt, prg, instances }; }
+	public:
+		inline DrawList& Add(Internal::VRefHandleWrapper vref,
+		                     const Internal::TextureBindingList& txt = {},
+		                     Internal::ShHandleArgumentWrapper prg = NULL_PRG,
+		                     fl32 depth = 0.f, bool transparent = false, size_t instances = 1){
+			LLJGFX::DrawList::Add(handle_, NULL_TXT, MakeRT(vref, txt, prg, instances), depth, transparent);
+			return *this;
+		}
+		inline DrawList& AddTo(Internal::TxtFnArg target, Internal::VRefHandleWrapper vref,
+		                       const Internal::TextureBindingList& txt = {},
+		                       Internal::ShHandleArgumentWrapper prg = NULL_PRG,
+		                       fl32 depth = 0.f, bool transparent = false, size_t instances = 1){
+			LLJGFX::DrawList::Add(handle_, target, MakeRT(vref, txt, prg, instances), depth, transparent);
+			return *this;
+		}
+
+		inline DrawList& Sort() { LLJGFX::DrawList::Sort(handle_); return *this; }
+		inline DrawList& Submit() { LLJGFX::DrawList::Submit(handle_); return *this; }
+		inline DrawList& Clear() { LLJGFX::DrawList::Clear(handle_); return *this; }
+
+		inline size_t size() const { return LLJGFX::DrawList::GetSize(handle_); }
+		inline LLJGFX::DrawList::Handle handle() const { return handle_; }
+
+		inline DrawList() { handle_ = LLJGFX::DrawList::Make(); }
+
+		inline DrawList& operator=(const DrawList& cpy) { LLJGFX::DrawList::Copy(handle_, cpy.handle_); return *this; }
+		inline DrawList(const DrawList& cpy) { handle_ = LLJGFX::DrawList::Make(); operator=(cpy); }
+
+		inline DrawList& operator=(DrawList&& cpy) noexcept {
+			this->~DrawList();
+			std::swap(handle_, cpy.handle_);
+			return *this;
+		}
+		inline DrawList(DrawList&& cpy) noexcept { operator=(std::move(cpy)); }
+
+		inline ~DrawList() { LLJGFX::DrawList::Delete(handle_); handle_ = { nullptr }; }
+	};
+
+	//GL-free recorder, can be filled from any thread. Submit it on the thread that owns the context
+	class CommandBuffer{
+	private:
+		LLJGFX::CommandBuffer::Handle handle_ = { nullptr };
+	public:
+		inline CommandBuffer& Draw(Internal::VRefHandleWrapper vref,
+		                           const Internal::TextureBindingList& txt = {},
+		                           Internal::ShHandleArgumentWrapper prg = NULL_PRG, size_t instances = 1){
+			LLJGFX::TmpRT rt = { vref.handle_, txt, prg, instances };
+			LLJGFX::CommandBuffer::RecordDraw(handle_, rt);
+			return *this;
+		}
+		inline CommandBuffer& Clear(uint8 r, uint8 g, uint8 b, uint8 a = 255)
+			{ LLJGFX::CommandBuffer::RecordClear(handle_, {r, g, b, a}); return *this; }
+		inline CommandBuffer& Clear(uint32 color)
+			{ LLJGFX::CommandBuffer::RecordClear(handle_, rgb{color}); return *this; }
+
+		inline CommandBuffer& BindFramebuffer(Internal::TxtFnArg fb)
+			{ LLJGFX::CommandBuffer::RecordBindFramebuffer(handle_, (LLJGFX::Texture::Handle)fb); return *this; }
+		inline CommandBuffer& BindFramebuffer(Internal::WinFnArg win)
+			{ LLJGFX::CommandBuffer::RecordBindFramebuffer(handle_, (LLJGFX::Window::Handle)win); return *this; }
+
+		template <typename T> inline CommandBuffer& SetUniform(Internal::ShHandleArgumentWrapper prg, const std::string& uniform, const T& value)
+			{ LLJGFX::CommandBuffer::RecordSetUniform(handle_, prg, uniform, value); return *this; }
+		template <typename T> inline CommandBuffer& SetUniform(Internal::ShHandleArgumentWrapper prg, const std::string& uniform,
+		                                                       const T* value, size_t element_count)
+			{ LLJGFX::CommandBuffer::RecordSetUniform(handle_, prg, uniform, value, element_count); return *this; }
+
+		inline CommandBuffer& Append(const CommandBuffer& oth)
+			{ LLJGFX::CommandBuffer::Append(handle_, oth.handle_); return *this; }
+		inline CommandBuffer& Reset() { LLJGFX::CommandBuffer::Reset(handle_); return *this; }
+		inline const CommandBuffer& Submit() const { LLJGFX::CommandBuffer::Submit(handle_); return *this; }
+		//Hands the commands over to the render thread(the buffer is left empty)
+		inline CommandBuffer& Enqueue() { LLJGFX::RenderThread::EnqueueCommands(handle_); return *this; }
+
+		inline size_t size() const { return LLJGFX::CommandBuffer::GetSize(handle_); }
+		inline LLJGFX::CommandBuffer::Handle handle() const { return handle_; }
+
+		inline CommandBuffer() { handle_ = LLJGFX::CommandBuffer::Make(); }
+
+		inline CommandBuffer& operator=(const CommandBuffer& cpy) {
+			if(this == &cpy) return *this;
+			Reset();
+			Append(cpy);
+			return *this;
+		}
+		inline CommandBuffer(const CommandBuffer& cpy) { handle_ = LLJGFX::CommandBuffer::Make(); operator=(cpy); }
+
+		inline CommandBuffer& operator=(CommandBuffer&& cpy) noexcept {
+			this->~CommandBuffer();
+			std::swap(handle_, cpy.handle_);
+			return *this;
+		}
+		inline CommandBuffer(CommandBuffer&& cpy) noexcept { operator=(std::move(cpy)); }
+
+		inline ~CommandBuffer() { LLJGFX::CommandBuffer::Delete(handle_); handle_ = { nullptr }; }
+	};
+
+	//Replays the buffers in the given order
+	inline void Submit(const std::vector<const CommandBuffer*>& buffers){
+		for(const CommandBuffer* i : buffers)
+			i->Submit();
+	}
+
+	//Merges consecutive draws of the same mesh, program and textures into one instanced draw.
+	//The payload type must match the instance layout, e.g. {{4, AttType<float>(), 4}, {5, AttType<float>(), 4}, ...} for a glm::mat4.
+	//The batch is flushed automatically before other draws and state changes(see LowLevel/Instancing.h), Flush() is needed
+	//only before changing the mesh data. The destructor flushes too, unless the window is already gone
+	class InstanceBatcher{
+	private:
+		LLJGFX::Batcher::Handle handle_ = { nullptr };
+	public:
+		template <typename T> inline InstanceBatcher& Draw(Internal::VRefHandleWrapper vref, const T& payload,
+		                                                   const Internal::TextureBindingList& txt = {},
+		                                                   Internal::ShHandleArgumentWrapper prg = NULL_PRG,
+		                                                   DrawRange range = {}){
+			LLJGFX::TmpRT rt = { vref.handle_, txt, prg, 1, range };
+			LLJGFX::Batcher::Draw(handle_, rt, payload);
+			return *this;
+		}
+		inline InstanceBatcher& Flush() { LLJGFX::Batcher::Flush(handle_); return *this; }
+
+		inline LLJGFX::Batcher::Stats stats() const { return LLJGFX::Batcher::GetStats(handle_); }
+		inline InstanceBatcher& ResetStats() { LLJGFX::Batcher::ResetStats(handle_); return *this; }
+		inline LLJGFX::Batcher::Handle handle() const { return handle_; }
+
+		inline InstanceBatcher(const VertexLayout& instance_layout) { handle_ = LLJGFX::Batcher::Make(instance_layout); }
+
+		InstanceBatcher(const InstanceBatcher&) = delete;
+		InstanceBatcher& operator=(const InstanceBatcher&) = delete;
+
+		inline InstanceBatcher& operator=(InstanceBatcher&& cpy) noexcept {
+			this->~InstanceBatcher();
+			std::swap(handle_, cpy.handle_);
+			return *this;
+		}
+		inline InstanceBatcher(InstanceBatcher&& cpy) noexcept { operator=(std::move(cpy)); }
+
+		inline ~InstanceBatcher() { LLJGFX::Batcher::Delete(handle_); handle_ = { nullptr }; }
+	};
+
 	using LLJGFX::Clear;
+	using LLJGFX::GetStateCacheStats;
+	using LLJGFX::GetFrameAllocationCount;
+	namespace FrameArena{
+		using namespace LLJGFX::FrameArena;
+	}
+	using LLJGFX::ProgramCacheStats;
+	namespace ProgramCache{
+		using namespace LLJGFX::ProgramCache;
+	}
 
 	namespace Opt{
 		using namespace LLJGFX::Opt;
 	}
+	namespace RenderThread{
+		using namespace LLJGFX::RenderThread;
+	}
 	//inline Texture& Texture::operator<<(const LLJGFX::TemporaryRT& target){
 	//	LLJGFX::DrawTo(handle_, target);
 	//	return *this;
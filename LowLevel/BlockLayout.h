@@ -0,0 +1,109 @@
+#pragma once
+#include <array>
+#include <tuple>
+#include <cstring>
+#include <type_traits>
+#include <glm/glm.hpp>
+
+#include "Common.h"
+
+//Compile-time std140/std430 packing of uniform(and storage) blocks.
+//A block is described by the types of its members in declaration order, e.g.
+//Std140Layout<glm::mat4, glm::mat4, glm::vec3, fl32> for {mat4 view; mat4 projection; vec3 position; float time;}
+namespace LLJGFX{
+	enum class BlockLayout{
+		STD140,
+		STD430
+	};
+
+	namespace Internal{
+		constexpr size_t RoundUp(size_t value, size_t alignment) { return (value + alignment - 1) / alignment * alignment; }
+
+		template<typename T, BlockLayout Layout> struct BlockMember{
+			static_assert(!std::is_same_v<T, T>, "Unsupported block member type");
+		};
+
+		template<typename T> struct BlockScalarMember{
+			static constexpr size_t alignment = 4;
+			static constexpr size_t size = 4;
+			static inline void Write(uint8* dst, const T& value) { memcpy(dst, &value, size); }
+		};
+		template<BlockLayout Layout> struct BlockMember<uint32, Layout> : BlockScalarMember<uint32> {};
+		template<BlockLayout Layout> struct BlockMember<int32, Layout> : BlockScalarMember<int32> {};
+		template<BlockLayout Layout> struct BlockMember<fl32, Layout> : BlockScalarMember<fl32> {};
+
+		//vec3 is aligned as vec4, but a scalar can still take its last 4 bytes
+		template<glm::length_t N, typename T, glm::qualifier Q, BlockLayout Layout> struct BlockMember<glm::vec<N, T, Q>, Layout>{
+			static_assert(sizeof(T) == 4, "Only 32 bit vector components are supported");
+			static constexpr size_t alignment = (N == 2 ? 2 : 4) * sizeof(T);
+			static constexpr size_t size = N * sizeof(T);
+			static inline void Write(uint8* dst, const glm::vec<N, T, Q>& value) { memcpy(dst, &value, size); }
+		};
+
+		//Stored as an array of columns, in std140 every column is padded to a vec4
+		template<glm::length_t C, glm::length_t R, typename T, glm::qualifier Q, BlockLayout Layout>
+		struct BlockMember<glm::mat<C, R, T, Q>, Layout>{
+			static constexpr size_t column_stride = Layout == BlockLayout::STD140 ? 16 : BlockMember<glm::vec<R, T, Q>, Layout>::alignment;
+			static constexpr size_t alignment = column_stride;
+			static constexpr size_t size = C * column_stride;
+			static inline void Write(uint8* dst, const glm::mat<C, R, T, Q>& value){
+				for(glm::length_t i = 0; i < C; i++)
+					memcpy(dst + i * column_stride, &value[i], R * sizeof(T));
+			}
+		};
+
+		//In std140 the element stride is rounded up to 16, in std430 it isn't
+		template<typename T, size_t N, BlockLayout Layout> struct BlockMember<std::array<T, N>, Layout>{
+			using Element = BlockMember<T, Layout>;
+			static constexpr size_t alignment = Layout == BlockLayout::STD140 ? RoundUp(Element::alignment, 16) : Element::alignment;
+			static constexpr size_t stride = RoundUp(Element::size, alignment);
+			static constexpr size_t size = N * stride;
+			static inline void Write(uint8* dst, const std::array<T, N>& value){
+				for(size_t i = 0; i < N; i++)
+					Element::Write(dst + i * stride, value[i]);
+			}
+		};
+	}
+
+	template<BlockLayout Layout, typename... Ts> struct UniformBlockLayout{
+		static constexpr size_t member_count = sizeof...(Ts);
+		template<size_t I> using MemberType = std::tuple_element_t<I, std::tuple<Ts...>>;
+
+		static constexpr std::array<size_t, member_count> offsets = []{
+			std::array<size_t, member_count> result = {};
+			size_t offset = 0;
+			size_t id = 0;
+			((offset = Internal::RoundUp(offset, Internal::BlockMember<Ts, Layout>::alignment),
+			  result[id++] = offset,
+			  offset += Internal::BlockMember<Ts, Layout>::size), ...);
+			return result;
+		}();
+		static constexpr std::array<size_t, member_count> sizes = { Internal::BlockMember<Ts, Layout>::size... };
+
+		//The end of the last member rounded up to a vec4, which is enough for any driver
+		static constexpr size_t size = member_count == 0 ? 16 :
+		                               Internal::RoundUp(offsets[member_count - 1] + sizes[member_count - 1], 16);
+
+		//Distance between the elements of an array of this struct(e.g. the particles of a storage buffer). std140 rounds
+		//the struct alignment up to a vec4, std430 keeps the largest member alignment
+		static constexpr size_t alignment = []{
+			size_t result = Layout == BlockLayout::STD140 || member_count == 0 ? 16 : 4;
+			((result = Internal::BlockMember<Ts, Layout>::alignment > result ? Internal::BlockMember<Ts, Layout>::alignment : result), ...);
+			return result;
+		}();
+		static constexpr size_t stride = member_count == 0 ? 16 :
+		                                 Internal::RoundUp(offsets[member_count - 1] + sizes[member_count - 1], alignment);
+
+		//"dst" must hold "size" bytes, the padding is left untouched
+		static inline void Pack(uint8* dst, const Ts&... values){
+			size_t id = 0;
+			(Internal::BlockMember<Ts, Layout>::Write(dst + offsets[id++], values), ...);
+		}
+		//Writes a single member to the start of "dst", it must hold sizes[I] bytes
+		template<size_t I> static inline void PackMember(uint8* dst, const MemberType<I>& value)
+			{ Internal::BlockMember<MemberType<I>, Layout>::Write(dst, value); }
+	};
+
+	template<typename... Ts> using Std140Layout = UniformBlockLayout<BlockLayout::STD140, Ts...>;
+	template<typename... Ts> using Std430Layout = UniformBlockLayout<BlockLayout::STD430, Ts...>;
+}
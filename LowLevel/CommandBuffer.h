@@ -0,0 +1,203 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <unordered_set>
+
+#include "Draw.h"
+#include "Window.h"
+#include "BlockLayout.h"
+
+//Command buffers don't touch GL or any global state while recording, so every thread can fill its own one.
+//Make() and Delete() are NOT thread safe(they register the buffer globally), so call them on the context thread.
+namespace LLJGFX{
+	namespace Internal{
+		enum class CommandType : uint8 {
+			DRAW,
+			CLEAR,
+			BIND_TEXTURE_FRAMEBUFFER,
+			BIND_WINDOW_FRAMEBUFFER,
+			SET_UNIFORM
+		};
+
+		struct Command{
+			CommandType type;
+			uint32 payload_id; //Index inside of the vector, that corresponds to the command type
+		};
+
+		constexpr size_t UNIFORM_DATA_ALIGNMENT = 16; //Values in the blob start at this, so they can be read as their type
+
+		struct UniformCommand{
+			ShaderProgram::Handle sh_handle;
+			Gpu::UniformType type;
+			uint32 element_count;
+			uint32 name_offset; //Offsets inside of CmdBuffDataHolder::blob
+			uint32 name_size;
+			uint32 data_offset;
+		};
+
+		struct CmdBuffDataHolder{
+			std::vector<Command> commands;
+
+			std::vector<TmpRT> draws;
+			std::vector<rgb> clear_colors;
+			std::vector<Texture::Handle> texture_framebuffers;
+			std::vector<Window::Handle> window_framebuffers;
+			std::vector<UniformCommand> uniforms;
+			std::vector<uint8> blob; //Uniform names and values, heap allocated so the aligned offsets are aligned in memory
+		};
+
+		std::unordered_set<CmdBuffDataHolder*> all_cmd_buff_handles;
+
+		inline void CheckCmdBuffValidity(CmdBuffDataHolder* data){
+			if(!all_cmd_buff_handles.contains(data))
+				throw std::runtime_error(data == nullptr ?
+				                         "Non-existent command buffer was requested using uninitialized handle" :
+				                         "Deleted command buffer was requested");
+		}
+
+		void ReplayCommands(const CmdBuffDataHolder& dat){
+			for(const Command& i : dat.commands){
+				switch(i.type){
+					case CommandType::DRAW: Draw(dat.draws[i.payload_id]); break;
+					case CommandType::CLEAR: Clear(dat.clear_colors[i.payload_id]); break;
+					case CommandType::BIND_TEXTURE_FRAMEBUFFER: BindFramebuffer(dat.texture_framebuffers[i.payload_id]); break;
+					case CommandType::BIND_WINDOW_FRAMEBUFFER: BindFramebuffer(dat.window_framebuffers[i.payload_id]); break;
+					case CommandType::SET_UNIFORM: {
+						const UniformCommand& uf = dat.uniforms[i.payload_id];
+						ShaderProgram::SetUniform(uf.sh_handle, std::string_view((const char*)dat.blob.data() + uf.name_offset, uf.name_size), uf.type,
+						                          dat.blob.data() + uf.data_offset, uf.element_count);
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	namespace CommandBuffer{
+		struct Handle{
+			Internal::CmdBuffDataHolder* data = nullptr;
+		};
+
+		inline bool IsValid(Handle handle) { return Internal::all_cmd_buff_handles.contains(handle.data); }
+
+		//Recording
+		inline void RecordDraw(Handle cmd_handle, const TmpRT& target){
+			Internal::CmdBuffDataHolder& dat = *cmd_handle.data;
+			dat.commands.push_back({Internal::CommandType::DRAW, (uint32)dat.draws.size()});
+			dat.draws.push_back(target);
+		}
+		inline void RecordDraw(Handle cmd_handle, VRef::Handle vr_handle,
+		                       const TextureBindings& texture_bindings = {},
+		                       ShaderProgram::Handle sh_handle = { nullptr }, size_t instances = 1)
+			{ RecordDraw(cmd_handle, {vr_handle, texture_bindings, sh_handle, instances}); }
+
+		inline void RecordClear(Handle cmd_handle, rgb color){
+			Internal::CmdBuffDataHolder& dat = *cmd_handle.data;
+			dat.commands.push_back({Internal::CommandType::CLEAR, (uint32)dat.clear_colors.size()});
+			dat.clear_colors.push_back(color);
+		}
+
+		inline void RecordBindFramebuffer(Handle cmd_handle, Texture::Handle txt_handle){
+			Internal::CmdBuffDataHolder& dat = *cmd_handle.data;
+			dat.commands.push_back({Internal::CommandType::BIND_TEXTURE_FRAMEBUFFER, (uint32)dat.texture_framebuffers.size()});
+			dat.texture_framebuffers.push_back(txt_handle);
+		}
+		inline void RecordBindFramebuffer(Handle cmd_handle, Window::Handle win_handle){
+			Internal::CmdBuffDataHolder& dat = *cmd_handle.data;
+			dat.commands.push_back({Internal::CommandType::BIND_WINDOW_FRAMEBUFFER, (uint32)dat.window_framebuffers.size()});
+			dat.window_framebuffers.push_back(win_handle);
+		}
+
+		inline void RecordSetUniform(Handle cmd_handle, ShaderProgram::Handle sh_handle, const std::string& uniform,
+		                             Internal::Gpu::UniformType type, const void* data, size_t element_count){
+			Internal::CmdBuffDataHolder& dat = *cmd_handle.data;
+			const size_t data_size = Internal::Gpu::type_size_table[(int32)type] * element_count;
+
+			const size_t name_offset = dat.blob.size();
+			dat.blob.insert(dat.blob.end(), uniform.begin(), uniform.end());
+			dat.blob.resize(Internal::RoundUp(dat.blob.size(), Internal::UNIFORM_DATA_ALIGNMENT), 0);
+			const size_t data_offset = dat.blob.size();
+			dat.blob.insert(dat.blob.end(), (const uint8*)data, (const uint8*)data + data_size);
+
+			dat.commands.push_back({Internal::CommandType::SET_UNIFORM, (uint32)dat.uniforms.size()});
+			dat.uniforms.push_back({sh_handle, type, (uint32)element_count,
+			                        (uint32)name_offset, (uint32)uniform.size(), (uint32)data_offset});
+		}
+		template<typename T> inline void RecordSetUniform(Handle cmd_handle, ShaderProgram::Handle sh_handle,
+		                                                  const std::string& uniform, const T* data, size_t element_count)
+			{ RecordSetUniform(cmd_handle, sh_handle, uniform, Internal::Gpu::DeduceUfType<T>(), (const void*)data, element_count); }
+		template<typename T> inline void RecordSetUniform(Handle cmd_handle, ShaderProgram::Handle sh_handle,
+		                                                  const std::string& uniform, const T& data)
+			{ RecordSetUniform(cmd_handle, sh_handle, uniform, &data, 1); }
+
+		inline void Reset(Handle cmd_handle){
+			Internal::CmdBuffDataHolder& dat = *cmd_handle.data;
+			dat.commands.clear();
+			dat.draws.clear();
+			dat.clear_colors.clear();
+			dat.texture_framebuffers.clear();
+			dat.window_framebuffers.clear();
+			dat.uniforms.clear();
+			dat.blob.clear();
+		}
+		inline size_t GetSize(Handle cmd_handle) { return cmd_handle.data->commands.size(); }
+
+		//Appends the commands of "from" to the end of "to"
+		inline void Append(Handle to, Handle from){
+			Internal::CmdBuffDataHolder& dst = *to.data;
+			const Internal::CmdBuffDataHolder& src = *from.data;
+
+			for(Internal::Command i : src.commands){
+				switch(i.type){
+					case Internal::CommandType::DRAW: i.payload_id += dst.draws.size(); break;
+					case Internal::CommandType::CLEAR: i.payload_id += dst.clear_colors.size(); break;
+					case Internal::CommandType::BIND_TEXTURE_FRAMEBUFFER: i.payload_id += dst.texture_framebuffers.size(); break;
+					case Internal::CommandType::BIND_WINDOW_FRAMEBUFFER: i.payload_id += dst.window_framebuffers.size(); break;
+					case Internal::CommandType::SET_UNIFORM: i.payload_id += dst.uniforms.size(); break;
+				}
+				dst.commands.push_back(i);
+			}
+			//Both blobs are padded the same way, so the shifted values stay aligned
+			dst.blob.resize(Internal::RoundUp(dst.blob.size(), Internal::UNIFORM_DATA_ALIGNMENT), 0);
+			const uint32 blob_shift = dst.blob.size();
+			for(Internal::UniformCommand i : src.uniforms){
+				i.name_offset += blob_shift;
+				i.data_offset += blob_shift;
+				dst.uniforms.push_back(i);
+			}
+
+			dst.draws.insert(dst.draws.end(), src.draws.begin(), src.draws.end());
+			dst.clear_colors.insert(dst.clear_colors.end(), src.clear_colors.begin(), src.clear_colors.end());
+			dst.texture_framebuffers.insert(dst.texture_framebuffers.end(), src.texture_framebuffers.begin(), src.texture_framebuffers.end());
+			dst.window_framebuffers.insert(dst.window_framebuffers.end(), src.window_framebuffers.begin(), src.window_framebuffers.end());
+			dst.blob.insert(dst.blob.end(), src.blob.begin(), src.blob.end());
+		}
+
+		//Replays on the context thread. The buffers are replayed in the order of the vector,
+		//not in the order they were finished, so the result doesn't depend on thread timing
+		inline void Submit(Handle cmd_handle){
+#ifndef NDEBUG
+			Internal::CheckCmdBuffValidity(cmd_handle.data);
+#endif
+			Internal::ReplayCommands(*cmd_handle.data);
+		}
+		inline void Submit(const std::vector<Handle>& cmd_handles){
+			for(const Handle i : cmd_handles)
+				Submit(i);
+		}
+
+		inline Handle Make(){
+			Handle handle = { new Internal::CmdBuffDataHolder{} };
+			Internal::all_cmd_buff_handles.insert(handle.data);
+			return handle;
+		}
+		inline void Delete(Handle cmd_handle){
+			if(cmd_handle.data == nullptr) return;
+#ifndef NDEBUG
+			Internal::CheckCmdBuffValidity(cmd_handle.data);
+#endif
+			Internal::all_cmd_buff_handles.erase(cmd_handle.data);
+			delete cmd_handle.data;
+		}
+	}
+}
@@ -1,5 +1,8 @@
 #pragma once
 #include <unordered_set>
+#include <vector>
+#include <utility>
+#include <stdexcept>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include "../pos2d.h"
@@ -20,7 +23,30 @@ namespace LLJGFX {
 			//Some additional data
 		};
 
-		WindowDataHolder* curr_context = nullptr;
+		//Per thread, like the current GL context itself(see RenderThread.h)
+		thread_local WindowDataHolder* curr_context = nullptr;
+
+		//GLFW answers window queries only on the main thread. While the render thread replays a frame, the sizes
+		//come from the frame packet, that the application thread sampled
+		thread_local const std::vector<std::pair<GLFWwindow*, pos2du16>>* replayed_window_sizes = nullptr;
+
+		inline pos2du16 GetWindowSize(GLFWwindow* win){
+			if(replayed_window_sizes != nullptr){
+				for(const std::pair<GLFWwindow*, pos2du16>& i : *replayed_window_sizes)
+					if(i.first == win) return i.second;
+				throw std::runtime_error("The window didn't exist when the frame was recorded");
+			}
+			int32 x_adapter;
+			int32 y_adapter;
+			glfwGetWindowSize(win, &x_adapter, &y_adapter);
+			return { x_adapter, y_adapter };
+		}
+
+		//Instance batches(see Instancing.h) are drawn late, so everything, that would change what a pending batch
+		//is drawn with(the target, the raster state, uniforms, textures), or that draws itself, calls this first.
+		//Instancing.h points it at the flush only while some batch is pending
+		void NoPendingBatches() {}
+		void (*FlushPendingBatches)() = NoPendingBatches;
 	}
 }
 
@@ -0,0 +1,164 @@
+#pragma once
+#include <unordered_set>
+
+#include "Shader.h"
+#include "BlockLayout.h"
+#include "../Mesh.hpp"
+#include "Gpu/Compute.h"
+
+//Compute programs are ShaderPrograms compiled with ShaderProgram::CompileCompute(), so they share the uniform
+//handling(and the caches) of the draw programs. Everything here needs GL 4.3 or ARB_compute_shader with
+//ARB_shader_storage_buffer_object
+namespace LLJGFX{
+	//What has to see the writes of a dispatch, combined with |
+	namespace Barrier{
+		constexpr uint32 VERTEX_ATTRIB_ARRAY = GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT; //Drawing from a storage buffer
+		constexpr uint32 ELEMENT_ARRAY = GL_ELEMENT_ARRAY_BARRIER_BIT;
+		constexpr uint32 UNIFORM = GL_UNIFORM_BARRIER_BIT;
+		constexpr uint32 TEXTURE_FETCH = GL_TEXTURE_FETCH_BARRIER_BIT;
+		constexpr uint32 SHADER_IMAGE_ACCESS = GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+		constexpr uint32 COMMAND = GL_COMMAND_BARRIER_BIT; //Indirect dispatches and draws
+		constexpr uint32 BUFFER_UPDATE = GL_BUFFER_UPDATE_BARRIER_BIT; //Reading a buffer back
+		constexpr uint32 SHADER_STORAGE = GL_SHADER_STORAGE_BARRIER_BIT; //The next dispatch
+		constexpr uint32 ALL = GL_ALL_BARRIER_BITS;
+	}
+
+	namespace Internal{
+		//The GL buffer is a VBuff, so it can be attached to a VRef and drawn from directly
+		struct SsboDataHolder{
+			VBuff::Handle vbuff;
+			size_t size = 0;
+		};
+
+		std::unordered_set<SsboDataHolder*> all_ssbo_handles;
+
+		void CheckSsboValidity(SsboDataHolder* data){
+			if(!all_ssbo_handles.contains(data))
+				throw std::runtime_error(data == nullptr ?
+				                         "Non-existent storage buffer was requested using uninitialized handle" :
+				                         "Deleted storage buffer was requested");
+		}
+		inline void CheckComputeSupport(){
+			if(!Gpu::IsComputeSupported())
+				throw std::runtime_error("Compute shaders need an OpenGL 4.3 context(or ARB_compute_shader and ARB_shader_storage_buffer_object)");
+		}
+
+		void InitializeCompute(){
+			Gpu::IsComputeSupported = Gpu::Opengl33::IsComputeSupported;
+			Gpu::DispatchCompute = Gpu::Opengl33::DispatchCompute;
+			Gpu::DispatchComputeIndirect = Gpu::Opengl33::DispatchComputeIndirect;
+			Gpu::InsertBarrier = Gpu::Opengl33::InsertBarrier;
+		}
+	}
+
+	//Like VBuffs they exist only after the initialization, so they call the GL backend directly
+	namespace StorageBuffer{
+		struct Handle{
+			Internal::SsboDataHolder* data = nullptr;
+		};
+
+		inline bool IsValid(Handle handle) { return Internal::all_ssbo_handles.contains(handle.data); }
+
+		//Can't be made before the initialization. "data" can be null, then the contents are undefined
+		inline Handle Make(size_t size, const void* data = nullptr){
+#ifndef NDEBUG
+			Internal::CheckComputeSupport();
+#endif
+			Handle handle = { new Internal::SsboDataHolder{VBuff::Make(), size} };
+			Internal::all_ssbo_handles.insert(handle.data);
+
+			Internal::Gpu::Opengl33::AllocateStorageBuffer(handle.data->vbuff.handle, size, data);
+			//The GPU writes the contents, so the VBuff keeps only the size instead of a CPU copy
+			Internal::VBuffDataHolder& vb_dat = Internal::find_vb_data(handle.data->vbuff);
+			vb_dat.is_gpu_only = true;
+			vb_dat.gpu_only_size = size;
+			return handle;
+		}
+		inline void Delete(Handle ssbo_handle){
+			if(ssbo_handle.data == nullptr) return;
+#ifndef NDEBUG
+			Internal::CheckSsboValidity(ssbo_handle.data);
+#endif
+			VBuff::Delete(ssbo_handle.data->vbuff); //Detaches it from the VRefs too
+			Internal::all_ssbo_handles.erase(ssbo_handle.data);
+			delete ssbo_handle.data;
+		}
+
+		inline void SetData(Handle ssbo_handle, const void* data, size_t size, size_t offset = 0){
+#ifndef NDEBUG
+			Internal::CheckSsboValidity(ssbo_handle.data);
+			if(offset + size > ssbo_handle.data->size)
+				throw std::runtime_error("The data is out of the storage buffer bounds");
+#endif
+			Internal::Gpu::Opengl33::SetStorageBufferData(ssbo_handle.data->vbuff.handle, offset, data, size);
+		}
+		//Writes element "index" of an array of "Layout" structs(see Std430Layout)
+		template<typename Layout, typename... Ts> inline void SetElement(Handle ssbo_handle, size_t index, const Ts&... values){
+			std::array<uint8, Layout::stride> packed = {};
+			Layout::Pack(packed.data(), values...);
+			SetData(ssbo_handle, packed.data(), packed.size(), index * Layout::stride);
+		}
+
+		//Stalls until the GPU is done with the buffer, a Barrier::BUFFER_UPDATE is needed after a dispatch writes it
+		inline void GetData(Handle ssbo_handle, void* dest, size_t size, size_t offset = 0){
+#ifndef NDEBUG
+			Internal::CheckSsboValidity(ssbo_handle.data);
+			if(offset + size > ssbo_handle.data->size)
+				throw std::runtime_error("The requested range is out of the storage buffer bounds");
+#endif
+			Internal::Gpu::Opengl33::GetStorageBufferData(ssbo_handle.data->vbuff.handle, offset, dest, size);
+		}
+
+		//Must match "layout(std430, binding = N)" of the shader
+		inline void Bind(Handle ssbo_handle, uint32 binding_point){
+#ifndef NDEBUG
+			Internal::CheckSsboValidity(ssbo_handle.data);
+#endif
+			Internal::Gpu::Opengl33::BindStorageBuffer(binding_point, ssbo_handle.data->vbuff.handle);
+		}
+
+		//Give it a layout with VBuff::SetLayout() and attach it with VRef::AttachVBuff() to draw from it.
+		//VBuff::SetSubData() and GetData() work on the GPU copy, VBuff::SetData() gives it a CPU copy again
+		inline VBuff::Handle GetVBuff(Handle ssbo_handle) { return ssbo_handle.data->vbuff; }
+		inline size_t GetSize(Handle ssbo_handle) { return ssbo_handle.data->size; }
+	}
+
+	namespace Internal{
+		//Async programs are waited for, a dispatch can't be skipped like a draw
+		inline void BindComputeProgram(ShaderProgram::Handle prg_handle){
+#ifndef NDEBUG
+			CheckComputeSupport();
+			CheckProgramValidity(prg_handle);
+			if(!ShaderProgram::IsCompute(prg_handle))
+				throw std::runtime_error("Only programs compiled with CompileCompute() can be dispatched");
+#endif
+			ProgramDataHolder& dat = *prg_handle.data;
+			FinishProgram(*dat.gpu);
+			Gpu::State::UseProgram(dat.gpu->gpu_handle);
+			CommitUniforms(dat);
+		}
+	}
+
+	namespace Compute{
+		inline bool IsSupported() { return Internal::Gpu::IsComputeSupported(); }
+
+		//Number of work groups in each dimension, the group size is declared by the shader
+		inline void Dispatch(ShaderProgram::Handle prg_handle, uint32 x, uint32 y = 1, uint32 z = 1){
+			Internal::BindComputeProgram(prg_handle);
+			Internal::Gpu::DispatchCompute(x, y, z);
+		}
+		//The group counts are read by the GPU from "args"(3 uint32 at "offset"), e.g. written by a previous dispatch
+		inline void DispatchIndirect(ShaderProgram::Handle prg_handle, StorageBuffer::Handle args, size_t offset = 0){
+#ifndef NDEBUG
+			Internal::CheckSsboValidity(args.data);
+			if(offset + 3 * sizeof(uint32) > args.data->size)
+				throw std::runtime_error("The dispatch arguments are out of the storage buffer bounds");
+#endif
+			Internal::BindComputeProgram(prg_handle);
+			Internal::Gpu::DispatchComputeIndirect(args.data->vbuff.handle, offset);
+		}
+
+		//Makes the writes of the previous dispatches visible to what is described by "barrier_bits"(see Barrier)
+		inline void InsertBarrier(uint32 barrier_bits = Barrier::ALL) { Internal::Gpu::InsertBarrier(barrier_bits); }
+	}
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include <glad/glad.h>
 
 #include <glm/glm.hpp>
@@ -8,6 +9,7 @@
 #include "Shader.h"
 #include "../Mesh.hpp"
 #include "Texture.h"
+#include "Pipeline.h"
 
 #include "Gpu/Draw.h"
 
@@ -17,76 +19,257 @@ namespace LLJGFX{
 		Texture::Handle texture_handle = { nullptr };
 	};
 
+	constexpr size_t MAX_DRAW_TEXTURES = Internal::Gpu::State::TEXTURE_UNIT_COUNT; //One binding per texture unit
+
+	//Fixed capacity array stored inline, so passing the bindings of a draw(even as a braced list) never allocates
+	class TextureBindings{
+	private:
+		std::array<TmpTextureSlotBinding, MAX_DRAW_TEXTURES> bindings_ = {};
+		size_t size_ = 0;
+	public:
+		inline void push_back(TmpTextureSlotBinding binding){
+			//Checked in every build, it would write past the end of the array otherwise
+			if(size_ == MAX_DRAW_TEXTURES)
+				throw std::runtime_error("A draw can't bind more than MAX_DRAW_TEXTURES textures");
+			bindings_[size_++] = binding;
+		}
+		inline void clear() { size_ = 0; }
+
+		inline size_t size() const { return size_; }
+		inline bool empty() const { return size_ == 0; }
+		inline const TmpTextureSlotBinding& operator[](size_t id) const { return bindings_[id]; }
+		inline TmpTextureSlotBinding& operator[](size_t id) { return bindings_[id]; }
+		inline const TmpTextureSlotBinding* begin() const { return bindings_.data(); }
+		inline const TmpTextureSlotBinding* end() const { return bindings_.data() + size_; }
+
+		TextureBindings() = default;
+		inline TextureBindings(std::initializer_list<TmpTextureSlotBinding> bindings)
+			{ for(const TmpTextureSlotBinding& i : bindings) push_back(i); }
+		inline TextureBindings(const std::vector<TmpTextureSlotBinding>& bindings)
+			{ for(const TmpTextureSlotBinding& i : bindings) push_back(i); }
+	};
+
+	//Part of the index buffer to draw. Lets many meshes share one VAO and one index buffer
+	struct DrawRange{
+		uint32 index_offset = 0;
+		uint32 index_count = 0; //0 means "up to the end of the index buffer"
+		int32 base_vertex = 0; //Added to every index before fetching the vertex
+	};
+
 	struct TmpRT { //"rt" means "rendering target"
 		VRef::Handle vr_handle;
-		std::vector<TmpTextureSlotBinding> texture_bindings;
+		TextureBindings texture_bindings;
 		ShaderProgram::Handle sh_handle = { nullptr };
 		size_t instances = 1;
+		DrawRange range = {};
+		PipelineState::Handle pipeline = { nullptr }; //Null means the Opt toggles
 	};
 
-	void Draw(VRef::Handle vr_handle,
-			  const std::vector<TmpTextureSlotBinding>& texture_bindings = {},
-			  ShaderProgram::Handle sh_handle = {nullptr }, size_t instances = 1){
-		Internal::UnbindBuffers();
+	namespace Internal{
+		//Nothing is unbound afterwards, the state cache drops every bind that wouldn't change anything.
+		//False means the program is still being built and has no fallback, so nothing should be drawn
+		bool BindDrawState(VRef::Handle vr_handle, const TextureBindings& texture_bindings,
+		                   ShaderProgram::Handle sh_handle, PipelineState::Handle pipeline_handle){
+			FlushPendingBatches();
+			ApplyPipeline(pipeline_handle);
+
+			//Set textures
+			for(const TmpTextureSlotBinding& i : texture_bindings){
+#ifndef NDEBUG
+				if(i.slot_id >= 32) throw std::runtime_error("Opengl does not support texture slot id, that is >= 32");
+#endif
+				if(i.texture_handle.data != nullptr)
+					Gpu::State::BindTextureUnit(i.slot_id, i.texture_handle.data->texture_gpu_handle);
+			}
 
+			//Without an explicit program the one of the pipeline or the one bound by the user is used
+			ShaderProgram::Handle prg = GetDrawProgram(sh_handle, pipeline_handle);
+			if(!ResolveDrawProgram(prg)) return false;
+			Gpu::State::UseProgram(GetGpuHandle(get_ro_pr_data(prg)));
+			if(prg.data != nullptr) CommitUniforms(*prg.data);
 
-		const GLenum texture_slot_ids[] = {GL_TEXTURE0,GL_TEXTURE1,GL_TEXTURE2,GL_TEXTURE3,
-										   GL_TEXTURE4,GL_TEXTURE5,GL_TEXTURE6,GL_TEXTURE7,
-										   GL_TEXTURE8,GL_TEXTURE9,GL_TEXTURE10, GL_TEXTURE11,
-										   GL_TEXTURE12, GL_TEXTURE13, GL_TEXTURE14, GL_TEXTURE15,
-										   GL_TEXTURE16, GL_TEXTURE17, GL_TEXTURE18, GL_TEXTURE19,
-										   GL_TEXTURE20, GL_TEXTURE21, GL_TEXTURE22, GL_TEXTURE23,
-										   GL_TEXTURE24, GL_TEXTURE25, GL_TEXTURE26, GL_TEXTURE27,
-										   GL_TEXTURE28, GL_TEXTURE29, GL_TEXTURE30, GL_TEXTURE31, };
+			Gpu::State::BindVertexArray(vr_handle.handle);
+			return true;
+		}
 
-		//Set textures
-		for(const TmpTextureSlotBinding& i : texture_bindings){
+		inline GLsizei ResolveIndexCount(const VRefDataHolder& dat, DrawRange range){
 #ifndef NDEBUG
-			if(i.slot_id >= 32) throw std::runtime_error("Opengl does not support texture slot id, that is >= 32");
+			if((size_t)range.index_offset + range.index_count > dat.ibuff_data.size())
+				throw std::runtime_error("The draw range is out of the index buffer bounds");
 #endif
-			glActiveTexture(texture_slot_ids[i.slot_id]);
-			if(i.texture_handle.data != nullptr)
-				glBindTexture(GL_TEXTURE_2D, i.texture_handle.data->texture_gpu_handle);
+			return (GLsizei)(range.index_count != 0 ? range.index_count : dat.ibuff_data.size() - range.index_offset);
 		}
 
-		if(sh_handle.data != nullptr)
-			glUseProgram(sh_handle.data->gpu_handle);
+		//Scratch arrays for MultiDraw(), kept to not allocate them every call
+		std::vector<GLsizei> multi_draw_counts;
+		std::vector<const void*> multi_draw_offsets;
+		std::vector<GLint> multi_draw_base_vertices;
+	}
 
-		glBindVertexArray(vr_handle.handle);
+	void Draw(VRef::Handle vr_handle, DrawRange range,
+	          const TextureBindings& texture_bindings = {},
+	          ShaderProgram::Handle sh_handle = {nullptr }, size_t instances = 1,
+	          PipelineState::Handle pipeline_handle = { nullptr }){
+		if(!Internal::BindDrawState(vr_handle, texture_bindings, sh_handle, pipeline_handle)) return;
 
 		const Internal::VRefDataHolder& dat = Internal::find_vr_data(vr_handle);
-		glDrawElementsInstanced(GL_TRIANGLES, (GLsizei)dat.ibuff_data.size(), GL_UNSIGNED_INT,
-		                        nullptr, (GLsizei)instances);
-
-		//Unset textures
-		for(const TmpTextureSlotBinding& i : texture_bindings){
-			glActiveTexture(texture_slot_ids[i.slot_id]);
-			if(i.texture_handle.data != nullptr)
-				glBindTexture(GL_TEXTURE_2D, 0);
+		const GLsizei index_count = Internal::ResolveIndexCount(dat, range);
+		const void* index_offset = (const void*)(range.index_offset * sizeof(HandleType));
+
+		if(range.base_vertex == 0)
+			glDrawElementsInstanced(GL_TRIANGLES, index_count, GL_UNSIGNED_INT, index_offset, (GLsizei)instances);
+		else glDrawElementsInstancedBaseVertex(GL_TRIANGLES, index_count, GL_UNSIGNED_INT, index_offset,
+		                                       (GLsizei)instances, range.base_vertex);
+	}
+	inline void Draw(VRef::Handle vr_handle,
+	                 const TextureBindings& texture_bindings = {},
+	                 ShaderProgram::Handle sh_handle = {nullptr }, size_t instances = 1)
+		{ Draw(vr_handle, DrawRange{}, texture_bindings, sh_handle, instances); }
+	inline void Draw(const TmpRT& target)
+		{ Draw(target.vr_handle, target.range, target.texture_bindings, target.sh_handle, target.instances, target.pipeline); }
+	//The program comes from the pipeline
+	inline void Draw(PipelineState::Handle pipeline_handle, VRef::Handle vr_handle,
+	                 const TextureBindings& texture_bindings = {},
+	                 DrawRange range = {}, size_t instances = 1)
+		{ Draw(vr_handle, range, texture_bindings, { nullptr }, instances, pipeline_handle); }
+
+	//Checks the vertex inputs of the program against the layouts of the buffers attached to the VRef: every input
+	//needs an attribute at its location, and integer inputs can't be fed through glVertexAttribPointer().
+	//Meant for debugging or for checking a mesh/program pair once, draws don't call it
+	void ValidateVertexInput(ShaderProgram::Handle sh_handle, VRef::Handle vr_handle){
+		const ProgramReflection& reflection = ShaderProgram::GetReflection(sh_handle);
+		const Internal::VRefDataHolder& vr_dat = Internal::find_vr_data(vr_handle);
+
+		std::string problems;
+		for(const ShaderVariable& i : reflection.attributes){
+			const JGFX::RestrictedVertexAttribute* attrib = nullptr;
+			for(const VBuff::Handle c_vb : vr_dat.bound_vertex_buffers){
+				const JGFX::VertexLayout& layout = Internal::find_vb_data(c_vb).layout;
+				if(layout.map().contains((HandleType)i.location)){
+					attrib = &layout[(HandleType)i.location];
+					break;
+				}
+			}
+
+			if(attrib == nullptr)
+				problems += "\n\"" + i.name + "\"(location " + std::to_string(i.location) + ") has no vertex attribute";
+			else if(Internal::Gpu::IsIntegerAttributeType(i.gl_type))
+				problems += "\n\"" + i.name + "\" is an integer input, it receives converted floats";
+			else if(attrib->amount > Internal::Gpu::GetAttributeComponentCount(i.gl_type))
+				problems += "\n\"" + i.name + "\" has fewer components than its vertex attribute";
+		}
+		if(!problems.empty())
+			throw std::runtime_error("The vertex input of the program does not match the mesh:" + problems);
+	}
+
+	namespace DrawFlags{
+		constexpr uint32 NONE = 0;
+		constexpr uint32 NO_VALIDATION = 1 << 0; //Skips the handle and range checks even in debug builds
+		constexpr uint32 NO_RASTER_STATE = 1 << 1; //Keeps the pipeline state(or the Opt toggles) applied by the previous draw
+		constexpr uint32 NO_PROGRAM_BIND = 1 << 2; //The caller has already bound the program(and committed its uniforms)
+	}
+
+	//Specialized path for callers that know their state. The slot count is a template parameter, so the texture
+	//binds are unrolled, and the range must have an explicit index count, so the mesh data isn't looked up at all.
+	//Everything, that the flags turn off, is compiled out
+	template<size_t SlotCount, uint32 Flags = DrawFlags::NONE>
+	inline void DrawFast(VRef::Handle vr_handle, DrawRange range,
+	                     const std::array<TmpTextureSlotBinding, SlotCount>& texture_bindings,
+	                     ShaderProgram::Handle sh_handle = { nullptr }, PipelineState::Handle pipeline_handle = { nullptr },
+	                     size_t instances = 1){
+		static_assert(SlotCount <= Internal::Gpu::State::TEXTURE_UNIT_COUNT, "Opengl does not support more than 32 texture slots");
+#ifndef NDEBUG
+		if constexpr(!(Flags & DrawFlags::NO_VALIDATION)){
+			if(range.index_count == 0)
+				throw std::runtime_error("DrawFast() needs an explicit index count");
+			Internal::ResolveIndexCount(Internal::find_vr_data(vr_handle), range); //Bounds check
+			for(const TmpTextureSlotBinding& i : texture_bindings)
+				if(i.slot_id >= 32) throw std::runtime_error("Opengl does not support texture slot id, that is >= 32");
+		}
+#endif
+		Internal::FlushPendingBatches();
+		if constexpr(!(Flags & DrawFlags::NO_RASTER_STATE))
+			Internal::ApplyPipeline(pipeline_handle);
+
+		for(const TmpTextureSlotBinding& i : texture_bindings)
+			if(i.texture_handle.data != nullptr) //Same as Draw(), an empty binding keeps what the unit has
+				Internal::Gpu::State::BindTextureUnit(i.slot_id, i.texture_handle.data->texture_gpu_handle);
+
+		if constexpr(!(Flags & DrawFlags::NO_PROGRAM_BIND)){
+			ShaderProgram::Handle prg = Internal::GetDrawProgram(sh_handle, pipeline_handle);
+			if(!Internal::ResolveDrawProgram(prg)) return;
+			Internal::Gpu::State::UseProgram(prg.data != nullptr ? Internal::GetGpuHandle(*prg.data) : 0);
+			if(prg.data != nullptr) Internal::CommitUniforms(*prg.data);
 		}
 
-		glBindVertexArray(0);
+		Internal::Gpu::State::BindVertexArray(vr_handle.handle);
 
-		if(sh_handle.data != nullptr)
-			Internal::RebindBoundShader();
+		const void* index_offset = (const void*)(range.index_offset * sizeof(HandleType));
+		if(range.base_vertex != 0)
+			glDrawElementsInstancedBaseVertex(GL_TRIANGLES, range.index_count, GL_UNSIGNED_INT, index_offset,
+			                                  (GLsizei)instances, range.base_vertex);
+		else if(instances != 1)
+			glDrawElementsInstanced(GL_TRIANGLES, range.index_count, GL_UNSIGNED_INT, index_offset, (GLsizei)instances);
+		else glDrawElements(GL_TRIANGLES, range.index_count, GL_UNSIGNED_INT, index_offset);
 	}
-	inline void Draw(const TmpRT& target)
-		{ Draw(target.vr_handle, target.texture_bindings, target.sh_handle, target.instances); }
+	template<uint32 Flags = DrawFlags::NONE>
+	inline void DrawFast(VRef::Handle vr_handle, DrawRange range,
+	                     ShaderProgram::Handle sh_handle = { nullptr }, PipelineState::Handle pipeline_handle = { nullptr },
+	                     size_t instances = 1)
+		{ DrawFast<0, Flags>(vr_handle, range, {}, sh_handle, pipeline_handle, instances); }
+
+	//Draws every range with a single VAO bind and a single call
+	void MultiDraw(VRef::Handle vr_handle, const DrawRange* ranges, size_t range_count,
+	               const TextureBindings& texture_bindings = {},
+	               ShaderProgram::Handle sh_handle = { nullptr }, PipelineState::Handle pipeline_handle = { nullptr }){
+		if(range_count == 0) return;
+		if(!Internal::BindDrawState(vr_handle, texture_bindings, sh_handle, pipeline_handle)) return;
+
+		const Internal::VRefDataHolder& dat = Internal::find_vr_data(vr_handle);
+		Internal::multi_draw_counts.resize(range_count);
+		Internal::multi_draw_offsets.resize(range_count);
+		Internal::multi_draw_base_vertices.resize(range_count);
+		for(size_t i = 0; i < range_count; i++){
+			Internal::multi_draw_counts[i] = Internal::ResolveIndexCount(dat, ranges[i]);
+			Internal::multi_draw_offsets[i] = (const void*)(ranges[i].index_offset * sizeof(HandleType));
+			Internal::multi_draw_base_vertices[i] = ranges[i].base_vertex;
+		}
+
+		glMultiDrawElementsBaseVertex(GL_TRIANGLES, Internal::multi_draw_counts.data(), GL_UNSIGNED_INT,
+		                              Internal::multi_draw_offsets.data(), (GLsizei)range_count,
+		                              Internal::multi_draw_base_vertices.data());
+	}
+	inline void MultiDraw(VRef::Handle vr_handle, const std::vector<DrawRange>& ranges,
+	                      const TextureBindings& texture_bindings = {},
+	                      ShaderProgram::Handle sh_handle = { nullptr }, PipelineState::Handle pipeline_handle = { nullptr })
+		{ MultiDraw(vr_handle, ranges.data(), ranges.size(), texture_bindings, sh_handle, pipeline_handle); }
 
 	inline void DrawTo(Texture::Handle fb_handle,
-					   VRef::Handle vr_handle, const std::vector<TmpTextureSlotBinding>& texture_bindings = {},
-					   ShaderProgram::Handle sh_handle = { nullptr }, size_t instances = 1){
+					   VRef::Handle vr_handle, DrawRange range, const TextureBindings& texture_bindings = {},
+					   ShaderProgram::Handle sh_handle = { nullptr }, size_t instances = 1,
+					   PipelineState::Handle pipeline_handle = { nullptr }){
 		Internal::Gpu::BindFramebuffer(Internal::GetTextureFramebufferHandle(fb_handle),
 		                               Texture::GetSize(fb_handle));
-		Draw(vr_handle, texture_bindings, sh_handle, instances);
+		Draw(vr_handle, range, texture_bindings, sh_handle, instances, pipeline_handle);
 		Internal::RebindBoundFramebuffer();
 	}
+	inline void DrawTo(Texture::Handle fb_handle,
+					   VRef::Handle vr_handle, const TextureBindings& texture_bindings = {},
+					   ShaderProgram::Handle sh_handle = { nullptr }, size_t instances = 1)
+		{ DrawTo(fb_handle, vr_handle, DrawRange{}, texture_bindings, sh_handle, instances); }
 	inline void DrawTo(Texture::Handle fb_handle, const TmpRT& target)
-		{ DrawTo(fb_handle, target.vr_handle, target.texture_bindings, target.sh_handle, target.instances); }
+		{ DrawTo(fb_handle, target.vr_handle, target.range, target.texture_bindings, target.sh_handle, target.instances, target.pipeline); }
 
-	inline void ClearDepthBuffer(){ glClear(GL_DEPTH_BUFFER_BIT); }
+	//Clears follow the Opt toggles(scissor test, depth writes), not the pipeline of the last draw
+	inline void ClearDepthBuffer(){
+		Internal::FlushPendingBatches();
+		Internal::ApplyPipeline({ nullptr });
+		glClear(GL_DEPTH_BUFFER_BIT);
+	}
 
 	inline void Clear(rgb color) {
+		Internal::FlushPendingBatches();
+		Internal::ApplyPipeline({ nullptr });
 		const glm::vec4 c_color = color;
 		glClearColor(c_color.r,
 		             c_color.g,
@@ -98,28 +281,18 @@ namespace LLJGFX{
 	inline void Clear(uint8 r, uint8 g, uint8 b, uint8 a = 255) { Clear({r, g, b, a}); }
 	inline void Clear(uint32 color) { Clear(rgb{color});}
 
+	//Draws without a pipeline state use these. Nothing is sent to GL here:
+	//the toggles are applied by the next such draw in whatever context is current then
 	namespace Opt{
 		inline void Enable(OptFtr feature){
-			//enable for all windows
-			if(!Internal::all_window_handles.empty()){
-				for(Internal::WindowDataHolder* i : Internal::all_window_handles){
-					glfwMakeContextCurrent(i->win);
-					Internal::Gpu::Enable(feature);
-				}
-				glfwMakeContextCurrent(Internal::curr_context->win);
-			}
+			Internal::FlushPendingBatches();
 			Internal::opt_modes[feature] = true;
+			Internal::UpdateLegacyRasterState();
 		}
 		inline void Disable(OptFtr feature){
-			//disable for all windows
-			if(!Internal::all_window_handles.empty()) {
-				for (Internal::WindowDataHolder *i: Internal::all_window_handles) {
-					glfwMakeContextCurrent(i->win);
-					Internal::Gpu::Disable(feature);
-				}
-				glfwMakeContextCurrent(Internal::curr_context->win);
-			}
+			Internal::FlushPendingBatches();
 			Internal::opt_modes[feature] = false;
+			Internal::UpdateLegacyRasterState();
 		}
 		inline bool IsActive(OptFtr feature) { return Internal::opt_modes[feature]; }
 	}
@@ -128,11 +301,8 @@ namespace LLJGFX{
 		void InitializeDraw(){
 			Gpu::Enable = Gpu::Opengl33::Enable;
 			Gpu::Disable = Gpu::Opengl33::Disable;
-			//enable/disable opt for all windows
-			for(int i = 0; i < Opt::STENCIL_TEST; i++){
-				if(opt_modes[i]) Gpu::Enable((Opt::OptFtr)i);
-				else Gpu::Disable((Opt::OptFtr)i);
-			}
+			Gpu::ApplyRasterState = Gpu::Opengl33::ApplyRasterState;
+			UpdateLegacyRasterState();
 		}
 	}
 }
\ No newline at end of file
@@ -0,0 +1,188 @@
+#pragma once
+#include <vector>
+#include <unordered_set>
+#include <algorithm>
+
+#include "Draw.h"
+
+namespace LLJGFX{
+	namespace Internal{
+		struct DrawListEntry{
+			uint64 key = 0;
+			Texture::Handle target = { nullptr }; //nullptr means "whatever is bound at the moment of submission"
+			TmpRT rt;
+		};
+		struct DrawListSortItem{
+			uint64 key;
+			uint32 entry_id;
+			uint32 pass_id; //Index of the entry's target in DrawListDataHolder::targets
+		};
+
+		struct DrawListDataHolder{
+			std::vector<DrawListEntry> entries;
+			std::vector<TxtDataHolder*> targets; //In the order of their first submission, every target is one pass
+			std::vector<DrawListSortItem> order;
+			std::vector<DrawListSortItem> sort_scratch;
+			bool is_sorted = true;
+		};
+
+		std::unordered_set<DrawListDataHolder*> all_draw_list_handles;
+
+		//LSD radix sort over the bytes of the key. The passes where every key has the same byte are skipped,
+		//so lists that only differ in a few fields are sorted in a couple of passes
+		void RadixSort(std::vector<DrawListSortItem>& items, std::vector<DrawListSortItem>& scratch){
+			scratch.resize(items.size());
+
+			for(uint32 shift = 0; shift < 64; shift += 8){
+				size_t histogram[256] = {};
+				for(const DrawListSortItem& i : items)
+					histogram[(i.key >> shift) & 0xFF]++;
+
+				if(histogram[(items.front().key >> shift) & 0xFF] == items.size())
+					continue;
+
+				size_t offset = 0;
+				for(size_t& i : histogram){
+					const size_t count = i;
+					i = offset;
+					offset += count;
+				}
+				for(const DrawListSortItem& i : items)
+					scratch[histogram[(i.key >> shift) & 0xFF]++] = i;
+
+				items.swap(scratch);
+			}
+		}
+		//Stable counting sort by the pass, done after RadixSort(), so the passes keep their submission order
+		//and the draws are sorted by the key only inside of their pass
+		void SortByPass(std::vector<DrawListSortItem>& items, std::vector<DrawListSortItem>& scratch, size_t pass_count){
+			if(pass_count < 2) return;
+			scratch.resize(items.size());
+
+			std::vector<size_t> offsets(pass_count + 1, 0);
+			for(const DrawListSortItem& i : items)
+				offsets[i.pass_id + 1]++;
+			for(size_t i = 1; i < offsets.size(); i++)
+				offsets[i] += offsets[i - 1];
+			for(const DrawListSortItem& i : items)
+				scratch[offsets[i.pass_id]++] = i;
+
+			items.swap(scratch);
+		}
+		uint32 GetDrawListPass(DrawListDataHolder& dat, TxtDataHolder* target){
+			for(size_t i = 0; i < dat.targets.size(); i++)
+				if(dat.targets[i] == target) return (uint32)i;
+			dat.targets.push_back(target);
+			return (uint32)dat.targets.size() - 1;
+		}
+	}
+
+	namespace DrawList{
+		struct Handle{
+			Internal::DrawListDataHolder* data = nullptr;
+		};
+
+		inline bool IsValid(Handle handle) { return Internal::all_draw_list_handles.contains(handle.data); }
+
+		constexpr uint32 DEPTH_BITS = 16;
+
+		//Key layout, from the most significant bits:
+		//opaque:      0 | program(16) | textures(16) | vao(15) | depth(16)
+		//transparent: 1 | inverted depth(16) | program(16) | textures(16) | vao(15)
+		//So state changes are grouped for opaque geometry(front to back inside of the same state),
+		//and transparent geometry is always drawn back to front after it.
+		//The key doesn't contain the target: the targets are drawn in the order they were first added to the list,
+		//and the keys only order the draws inside of each target
+		inline uint64 MakeKey(const TmpRT& rt, fl32 depth = 0.f, bool transparent = false){
+			const uint64 program_id = Internal::GetGpuHandle(Internal::get_ro_pr_data(Internal::GetDrawProgram(rt.sh_handle, rt.pipeline))) & 0xFFFF;
+			const uint64 vao_id = rt.vr_handle.handle & 0x7FFF;
+
+			uint64 textures_id = 0;
+			for(const TmpTextureSlotBinding& i : rt.texture_bindings)
+				textures_id = textures_id * 31 + ((uint64)i.slot_id << 32 | Internal::get_ro_txt_data(i.texture_handle).texture_gpu_handle);
+			textures_id = (textures_id ^ (textures_id >> 16) ^ (textures_id >> 32) ^ (textures_id >> 48)) & 0xFFFF;
+
+			const uint64 depth_id = (uint64)(std::clamp(depth, 0.f, 1.f) * (fl32)((1 << DEPTH_BITS) - 1));
+
+			if(!transparent)
+				return program_id << 47 | textures_id << 31 | vao_id << 16 | depth_id;
+			return (uint64)1 << 63 | (0xFFFF - depth_id) << 47 | program_id << 31 | textures_id << 15 | vao_id;
+		}
+
+		inline void Add(Handle list_handle, uint64 key, Texture::Handle target, const TmpRT& rt){
+#ifndef NDEBUG
+			if(!IsValid(list_handle))
+				throw std::runtime_error("Deleted or uninitialized draw list was requested");
+#endif
+			Internal::DrawListDataHolder& dat = *list_handle.data;
+			dat.order.push_back({key, (uint32)dat.entries.size(), Internal::GetDrawListPass(dat, target.data)});
+			dat.entries.push_back({key, target, rt});
+			dat.is_sorted = false;
+		}
+		inline void Add(Handle list_handle, Texture::Handle target, const TmpRT& rt, fl32 depth = 0.f, bool transparent = false)
+			{ Add(list_handle, MakeKey(rt, depth, transparent), target, rt); }
+
+		inline void Sort(Handle list_handle){
+			Internal::DrawListDataHolder& dat = *list_handle.data;
+			if(dat.is_sorted || dat.order.empty()) return;
+
+			Internal::RadixSort(dat.order, dat.sort_scratch);
+			Internal::SortByPass(dat.order, dat.sort_scratch, dat.targets.size());
+			dat.is_sorted = true;
+		}
+
+		//Draws the targets in the order they were first added, and the draws of each target in the key order. The entries are kept, so a static list can be submitted every frame
+		inline void Submit(Handle list_handle){
+#ifndef NDEBUG
+			if(!IsValid(list_handle))
+				throw std::runtime_error("Deleted or uninitialized draw list was requested");
+#endif
+			Sort(list_handle);
+			const Internal::DrawListDataHolder& dat = *list_handle.data;
+			if(dat.order.empty()) return;
+
+			Internal::TxtDataHolder* curr_target = nullptr;
+			for(const Internal::DrawListSortItem& i : dat.order){
+				const Internal::DrawListEntry& entry = dat.entries[i.entry_id];
+
+				if(entry.target.data != curr_target){
+					if(entry.target.data == nullptr) Internal::RebindBoundFramebuffer();
+					else Internal::Gpu::BindFramebuffer(Internal::GetTextureFramebufferHandle(entry.target),
+					                                    Texture::GetSize(entry.target));
+					curr_target = entry.target.data;
+				}
+				Draw(entry.rt);
+			}
+
+			if(curr_target != nullptr)
+				Internal::RebindBoundFramebuffer();
+		}
+
+		inline void Clear(Handle list_handle){
+			Internal::DrawListDataHolder& dat = *list_handle.data;
+			dat.entries.clear();
+			dat.targets.clear();
+			dat.order.clear();
+			dat.is_sorted = true;
+		}
+		inline size_t GetSize(Handle list_handle) { return list_handle.data->entries.size(); }
+
+		inline Handle Make(){
+			Handle handle = { new Internal::DrawListDataHolder{} };
+			Internal::all_draw_list_handles.insert(handle.data);
+			return handle;
+		}
+		inline void Copy(Handle to, Handle from){
+			to.data->entries = from.data->entries;
+			to.data->targets = from.data->targets;
+			to.data->order = from.data->order;
+			to.data->is_sorted = from.data->is_sorted;
+		}
+		inline void Delete(Handle list_handle){
+			if(list_handle.data == nullptr) return;
+
+			Internal::all_draw_list_handles.erase(list_handle.data);
+			delete list_handle.data;
+		}
+	}
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <cstdint>
+#include <type_traits>
+
+#include "Common.h"
+
+//Linear allocator for the data, that lives until the end of the frame. NewFrame() resets it.
+//If a frame needs more than the capacity, the rest is served from separate blocks and the next
+//Reset() grows the main block, so a steady workload stops allocating after the first frames.
+//Only the application thread may use it
+namespace LLJGFX{
+	namespace Internal{
+		struct FrameArenaData{
+			std::unique_ptr<uint8[]> block;
+			size_t capacity = 0;
+			size_t offset = 0;
+
+			std::vector<std::unique_ptr<uint8[]>> overflow_blocks;
+			size_t overflow_size = 0;
+		};
+		FrameArenaData frame_arena;
+
+		//Heap allocations since the last NewFrame(), counted only with JGFX_COUNT_ALLOCATIONS defined
+		std::atomic<uint64> frame_allocations = 0;
+		uint64 last_frame_allocations = 0;
+
+		inline uint8* AlignPointer(uint8* ptr, size_t alignment)
+			{ return (uint8*)(((uintptr_t)ptr + alignment - 1) & ~(uintptr_t)(alignment - 1)); }
+	}
+
+	namespace FrameArena{
+		inline void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t)){
+			Internal::FrameArenaData& arena = Internal::frame_arena;
+
+			if(arena.block != nullptr){
+				uint8* ptr = Internal::AlignPointer(arena.block.get() + arena.offset, alignment);
+				if(ptr + size <= arena.block.get() + arena.capacity){
+					arena.offset = ptr + size - arena.block.get();
+					return ptr;
+				}
+			}
+
+			arena.overflow_blocks.emplace_back(new uint8[size + alignment]);
+			arena.overflow_size += size + alignment;
+			return Internal::AlignPointer(arena.overflow_blocks.back().get(), alignment);
+		}
+		//Value-initialized, the destructors are never called
+		template<typename T> inline T* AllocateArray(size_t count){
+			static_assert(std::is_trivially_destructible_v<T>, "The frame arena doesn't call destructors");
+			T* ptr = (T*)Allocate(sizeof(T) * count, alignof(T));
+			for(size_t i = 0; i < count; i++)
+				new(ptr + i) T();
+			return ptr;
+		}
+
+		//Everything allocated before is invalidated
+		inline void Reset(){
+			Internal::FrameArenaData& arena = Internal::frame_arena;
+			if(arena.overflow_size != 0){
+				arena.capacity += arena.overflow_size;
+				arena.block.reset(new uint8[arena.capacity]);
+				arena.overflow_blocks.clear();
+				arena.overflow_size = 0;
+			}
+			arena.offset = 0;
+		}
+		inline void Reserve(size_t capacity){
+			Internal::FrameArenaData& arena = Internal::frame_arena;
+			if(capacity <= arena.capacity) return;
+			arena.capacity = capacity;
+			arena.block.reset(new uint8[arena.capacity]);
+			arena.offset = 0;
+		}
+
+		inline size_t GetUsedSize() { return Internal::frame_arena.offset + Internal::frame_arena.overflow_size; }
+		inline size_t GetCapacity() { return Internal::frame_arena.capacity; }
+	}
+
+	namespace Internal{
+		inline void EndFrameAllocations()
+			{ last_frame_allocations = frame_allocations.exchange(0, std::memory_order_relaxed); }
+	}
+
+	//Heap allocations(on every thread) made during the last finished frame.
+	//Always 0, unless JGFX_COUNT_ALLOCATIONS is defined before including JGFX
+	inline uint64 GetFrameAllocationCount() { return Internal::last_frame_allocations; }
+}
+
+#ifdef JGFX_COUNT_ALLOCATIONS
+void* operator new(std::size_t size){
+	LLJGFX::Internal::frame_allocations.fetch_add(1, std::memory_order_relaxed);
+	if(void* ptr = std::malloc(size != 0 ? size : 1)) return ptr;
+	throw std::bad_alloc();
+}
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+#endif
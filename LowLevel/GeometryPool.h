@@ -0,0 +1,320 @@
+#pragma once
+#include <map>
+#include <vector>
+#include <unordered_set>
+#include <algorithm>
+
+#include "Draw.h"
+#include "FrameArena.h"
+
+//Many small meshes with the same vertex layout packed into one vertex buffer, one index buffer and one VAO.
+//Every mesh is a sub-range of them, that is drawn with a base vertex, so the index data stays mesh-local
+namespace LLJGFX{
+	namespace Internal{
+		//First-fit free-list allocator. Neighbouring free blocks are merged back on Free()
+		struct RangeAllocator{
+			uint32 capacity = 0;
+			std::map<uint32, uint32> free_blocks; //offset -> size
+
+			bool Allocate(uint32 size, uint32& offset){
+				for(std::map<uint32, uint32>::iterator i = free_blocks.begin(); i != free_blocks.end(); i++){
+					if(i->second < size) continue;
+
+					offset = i->first;
+					const uint32 rest = i->second - size;
+					free_blocks.erase(i);
+					if(rest != 0) free_blocks[offset + size] = rest;
+					return true;
+				}
+				return false;
+			}
+			void Free(uint32 offset, uint32 size){
+				if(size == 0) return;
+				std::map<uint32, uint32>::iterator curr = free_blocks.insert({offset, size}).first;
+
+				std::map<uint32, uint32>::iterator next = std::next(curr);
+				if(next != free_blocks.end() && curr->first + curr->second == next->first){
+					curr->second += next->second;
+					free_blocks.erase(next);
+				}
+				if(curr != free_blocks.begin()){
+					std::map<uint32, uint32>::iterator prev = std::prev(curr);
+					if(prev->first + prev->second == curr->first){
+						prev->second += curr->second;
+						free_blocks.erase(curr);
+					}
+				}
+			}
+			void Grow(uint32 new_capacity){
+				Free(capacity, new_capacity - capacity);
+				capacity = new_capacity;
+			}
+			void Reset(uint32 used){
+				free_blocks.clear();
+				if(used < capacity) free_blocks[used] = capacity - used;
+			}
+
+			uint32 GetFreeSize() const {
+				uint32 res = 0;
+				for(const std::pair<const uint32, uint32>& i : free_blocks) res += i.second;
+				return res;
+			}
+			uint32 GetLargestFreeBlock() const {
+				uint32 res = 0;
+				for(const std::pair<const uint32, uint32>& i : free_blocks) res = std::max(res, i.second);
+				return res;
+			}
+		};
+
+		struct PoolMeshData{
+			uint32 vertex_offset = 0;
+			uint32 vertex_count = 0;
+			uint32 index_offset = 0;
+			uint32 index_count = 0;
+			bool is_alive = false;
+		};
+
+		struct GeoPoolDataHolder{
+			size_t stride = 0;
+			VBuff::Handle vbuff = { INVALID_HANDLE };
+			VRef::Handle vref = { INVALID_HANDLE };
+
+			RangeAllocator vertices;
+			RangeAllocator indices;
+
+			std::vector<PoolMeshData> meshes;
+			std::vector<uint32> free_mesh_ids;
+		};
+
+		std::unordered_set<GeoPoolDataHolder*> all_geo_pool_handles;
+
+		inline void CheckGeoPoolValidity(GeoPoolDataHolder* data){
+			if(!all_geo_pool_handles.contains(data))
+				throw std::runtime_error(data == nullptr ?
+				                         "Non-existent geometry pool was requested using uninitialized handle" :
+				                         "Deleted geometry pool was requested");
+		}
+
+		//Doubles the capacity until the requested amount fits at the end
+		inline void GrowPool(GeoPoolDataHolder& dat, uint32 vertex_count, uint32 index_count){
+			if(vertex_count != 0 && dat.vertices.GetLargestFreeBlock() < vertex_count){
+				uint32 new_capacity = std::max(dat.vertices.capacity, (uint32)1);
+				while(new_capacity < dat.vertices.capacity + vertex_count)
+					new_capacity *= 2;
+
+				VBuff::Resize(dat.vbuff, new_capacity * dat.stride);
+				dat.vertices.Grow(new_capacity);
+			}
+			if(index_count != 0 && dat.indices.GetLargestFreeBlock() < index_count){
+				uint32 new_capacity = std::max(dat.indices.capacity, (uint32)1);
+				while(new_capacity < dat.indices.capacity + index_count)
+					new_capacity *= 2;
+
+				VRef::ResizeIndexingData(dat.vref, new_capacity);
+				dat.indices.Grow(new_capacity);
+			}
+		}
+	}
+
+	namespace GeoPool{
+		struct Handle{
+			Internal::GeoPoolDataHolder* data = nullptr;
+		};
+		struct Mesh{
+			Internal::GeoPoolDataHolder* pool = nullptr;
+			uint32 id = 0;
+		};
+
+		struct Stats{
+			size_t vertex_capacity = 0; //In vertices
+			size_t vertex_used = 0;
+			size_t index_capacity = 0; //In indices
+			size_t index_used = 0;
+			size_t mesh_count = 0;
+
+			size_t allocated_bytes = 0; //Size of the GPU storage
+			size_t unused_bytes = 0; //Part of it that isn't used by any mesh
+			fl32 vertex_fragmentation = 0.f; //1 - largest free block / all free space, 0 means no fragmentation at all
+			fl32 index_fragmentation = 0.f;
+		};
+
+		inline bool IsValid(Handle pool_handle) { return Internal::all_geo_pool_handles.contains(pool_handle.data); }
+
+		inline Handle Make(const JGFX::VertexLayout& layout, size_t vertex_capacity = 65536, size_t index_capacity = 65536 * 3){
+			Handle handle = { new Internal::GeoPoolDataHolder{} };
+			Internal::all_geo_pool_handles.insert(handle.data);
+			Internal::GeoPoolDataHolder& dat = *handle.data;
+
+			dat.stride = layout.CalculateStride();
+			dat.vbuff = VBuff::Make();
+			VBuff::SetLayout(dat.vbuff, layout);
+			dat.vref = VRef::Make();
+			VRef::AttachVBuff(dat.vref, dat.vbuff);
+
+			VBuff::Resize(dat.vbuff, vertex_capacity * dat.stride);
+			VRef::ResizeIndexingData(dat.vref, index_capacity);
+			dat.vertices.Grow((uint32)vertex_capacity);
+			dat.indices.Grow((uint32)index_capacity);
+			return handle;
+		}
+		inline void Delete(Handle pool_handle){
+			if(pool_handle.data == nullptr) return;
+#ifndef NDEBUG
+			Internal::CheckGeoPoolValidity(pool_handle.data);
+#endif
+			VRef::Delete(pool_handle.data->vref);
+			VBuff::Delete(pool_handle.data->vbuff);
+
+			Internal::all_geo_pool_handles.erase(pool_handle.data);
+			delete pool_handle.data;
+		}
+
+		//The indices are local to the mesh(the first vertex of the mesh has index 0)
+		template<typename T> inline Mesh AddMesh(Handle pool_handle, const T* vertices, size_t vertex_count,
+		                                         const HandleType* indices, size_t index_count){
+#ifndef NDEBUG
+			Internal::CheckGeoPoolValidity(pool_handle.data);
+#endif
+			Internal::GeoPoolDataHolder& dat = *pool_handle.data;
+			const size_t byte_size = sizeof(T) * vertex_count;
+			if(byte_size % dat.stride)
+				throw std::runtime_error("The vertex data given to GeometryPool does not match the layout");
+
+			Internal::PoolMeshData mesh = { 0, (uint32)(byte_size / dat.stride), 0, (uint32)index_count, true };
+
+			Internal::GrowPool(dat, mesh.vertex_count, mesh.index_count);
+			if(mesh.vertex_count != 0) dat.vertices.Allocate(mesh.vertex_count, mesh.vertex_offset);
+			if(mesh.index_count != 0) dat.indices.Allocate(mesh.index_count, mesh.index_offset);
+
+			VBuff::SetSubData(dat.vbuff, mesh.vertex_offset * dat.stride, vertices, byte_size);
+			VRef::SetIndexingSubData(dat.vref, mesh.index_offset, indices, index_count);
+
+			uint32 id = (uint32)dat.meshes.size();
+			if(!dat.free_mesh_ids.empty()){
+				id = dat.free_mesh_ids.back();
+				dat.free_mesh_ids.pop_back();
+				dat.meshes[id] = mesh;
+			}
+			else dat.meshes.push_back(mesh);
+
+			return { pool_handle.data, id };
+		}
+		template<typename T> inline Mesh AddMesh(Handle pool_handle, const std::vector<T>& vertices, const std::vector<HandleType>& indices)
+			{ return AddMesh(pool_handle, vertices.data(), vertices.size(), indices.data(), indices.size()); }
+
+		inline void RemoveMesh(Mesh mesh){
+#ifndef NDEBUG
+			Internal::CheckGeoPoolValidity(mesh.pool);
+			if(mesh.id >= mesh.pool->meshes.size() || !mesh.pool->meshes[mesh.id].is_alive)
+				throw std::runtime_error("Removed or non-existent geometry pool mesh was requested");
+#endif
+			Internal::GeoPoolDataHolder& dat = *mesh.pool;
+			Internal::PoolMeshData& mesh_dat = dat.meshes[mesh.id];
+
+			dat.vertices.Free(mesh_dat.vertex_offset, mesh_dat.vertex_count);
+			dat.indices.Free(mesh_dat.index_offset, mesh_dat.index_count);
+			mesh_dat.is_alive = false;
+			dat.free_mesh_ids.push_back(mesh.id);
+		}
+
+		inline DrawRange GetRange(Mesh mesh){
+			const Internal::PoolMeshData& mesh_dat = mesh.pool->meshes[mesh.id];
+			return { mesh_dat.index_offset, mesh_dat.index_count, (int32)mesh_dat.vertex_offset };
+		}
+		inline VRef::Handle GetVRef(Handle pool_handle) { return pool_handle.data->vref; }
+		inline VRef::Handle GetVRef(Mesh mesh) { return mesh.pool->vref; }
+
+		//Packs every mesh to the beginning of the buffers, so all the free space becomes one block.
+		//Mesh handles stay valid, only their ranges change
+		inline void Defragment(Handle pool_handle){
+#ifndef NDEBUG
+			Internal::CheckGeoPoolValidity(pool_handle.data);
+#endif
+			Internal::GeoPoolDataHolder& dat = *pool_handle.data;
+
+			std::vector<uint32> by_vertex_offset;
+			std::vector<uint32> by_index_offset;
+			for(uint32 i = 0; i < dat.meshes.size(); i++){
+				if(!dat.meshes[i].is_alive) continue;
+				by_vertex_offset.push_back(i);
+				by_index_offset.push_back(i);
+			}
+			std::sort(by_vertex_offset.begin(), by_vertex_offset.end(),
+			          [&dat](uint32 a, uint32 b){ return dat.meshes[a].vertex_offset < dat.meshes[b].vertex_offset; });
+			std::sort(by_index_offset.begin(), by_index_offset.end(),
+			          [&dat](uint32 a, uint32 b){ return dat.meshes[a].index_offset < dat.meshes[b].index_offset; });
+
+			//Moving to lower offsets in the ascending order never overwrites data that wasn't moved yet
+			std::vector<uint8>& vertex_binary = Internal::find_vb_data(dat.vbuff).binary;
+			uint32 vertex_end = 0;
+			for(const uint32 i : by_vertex_offset){
+				Internal::PoolMeshData& mesh = dat.meshes[i];
+				memmove(vertex_binary.data() + vertex_end * dat.stride,
+				        vertex_binary.data() + mesh.vertex_offset * dat.stride, mesh.vertex_count * dat.stride);
+				mesh.vertex_offset = vertex_end;
+				vertex_end += mesh.vertex_count;
+			}
+
+			std::vector<HandleType>& index_binary = Internal::find_vr_data(dat.vref).ibuff_data;
+			uint32 index_end = 0;
+			for(const uint32 i : by_index_offset){
+				Internal::PoolMeshData& mesh = dat.meshes[i];
+				memmove(index_binary.data() + index_end, index_binary.data() + mesh.index_offset,
+				        mesh.index_count * sizeof(HandleType));
+				mesh.index_offset = index_end;
+				index_end += mesh.index_count;
+			}
+
+			//One upload per buffer instead of one per moved mesh
+			VBuff::Resize(dat.vbuff, vertex_binary.size());
+			VRef::ResizeIndexingData(dat.vref, index_binary.size());
+			dat.vertices.Reset(vertex_end);
+			dat.indices.Reset(index_end);
+		}
+
+		inline Stats GetStats(Handle pool_handle){
+			const Internal::GeoPoolDataHolder& dat = *pool_handle.data;
+			Stats res;
+			res.vertex_capacity = dat.vertices.capacity;
+			res.vertex_used = dat.vertices.capacity - dat.vertices.GetFreeSize();
+			res.index_capacity = dat.indices.capacity;
+			res.index_used = dat.indices.capacity - dat.indices.GetFreeSize();
+			res.mesh_count = dat.meshes.size() - dat.free_mesh_ids.size();
+
+			res.allocated_bytes = res.vertex_capacity * dat.stride + res.index_capacity * sizeof(HandleType);
+			res.unused_bytes = (res.vertex_capacity - res.vertex_used) * dat.stride +
+			                   (res.index_capacity - res.index_used) * sizeof(HandleType);
+
+			const uint32 vertex_free = dat.vertices.GetFreeSize();
+			const uint32 index_free = dat.indices.GetFreeSize();
+			if(vertex_free) res.vertex_fragmentation = 1.f - (fl32)dat.vertices.GetLargestFreeBlock() / (fl32)vertex_free;
+			if(index_free) res.index_fragmentation = 1.f - (fl32)dat.indices.GetLargestFreeBlock() / (fl32)index_free;
+			return res;
+		}
+	}
+
+	inline void Draw(GeoPool::Mesh mesh, const TextureBindings& texture_bindings = {},
+	                 ShaderProgram::Handle sh_handle = { nullptr }, size_t instances = 1,
+	                 PipelineState::Handle pipeline_handle = { nullptr }){
+		const DrawRange range = GeoPool::GetRange(mesh);
+		if(range.index_count == 0) return; //0 would mean "the whole index buffer" for a regular draw
+		Draw(GeoPool::GetVRef(mesh), range, texture_bindings, sh_handle, instances, pipeline_handle);
+	}
+
+	//All meshes must be from the same pool
+	inline void MultiDraw(const std::vector<GeoPool::Mesh>& meshes, const TextureBindings& texture_bindings = {},
+	                      ShaderProgram::Handle sh_handle = { nullptr }, PipelineState::Handle pipeline_handle = { nullptr }){
+		if(meshes.empty()) return;
+		DrawRange* ranges = FrameArena::AllocateArray<DrawRange>(meshes.size());
+		size_t range_count = 0;
+		for(const GeoPool::Mesh& i : meshes){
+#ifndef NDEBUG
+			if(i.pool != meshes.front().pool)
+				throw std::runtime_error("Meshes from different geometry pools can't be drawn with one call");
+#endif
+			const DrawRange range = GeoPool::GetRange(i);
+			if(range.index_count != 0) ranges[range_count++] = range;
+		}
+		MultiDraw(GeoPool::GetVRef(meshes.front()), ranges, range_count, texture_bindings, sh_handle, pipeline_handle);
+	}
+}
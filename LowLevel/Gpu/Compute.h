@@ -0,0 +1,51 @@
+#pragma once
+#include <glad/glad.h>
+
+#include "../Common.h"
+#include "State.h"
+
+namespace LLJGFX{
+	namespace Internal{
+		namespace Gpu{
+			namespace Opengl33{
+				//Compute shaders came with GL 4.3, older contexts can have them as extensions
+				bool IsComputeSupported()
+					{ return GLAD_GL_VERSION_4_3 || (GLAD_GL_ARB_compute_shader && GLAD_GL_ARB_shader_storage_buffer_object); }
+
+				void DispatchCompute(uint32 x, uint32 y, uint32 z) { glDispatchCompute(x, y, z); }
+				//The buffer holds 3 uint32 group counts at "offset"
+				void DispatchComputeIndirect(HandleType buff, size_t offset){
+					glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, buff);
+					glDispatchComputeIndirect((GLintptr)offset);
+				}
+				void InsertBarrier(uint32 barrier_bits) { glMemoryBarrier(barrier_bits); }
+
+				void AllocateStorageBuffer(HandleType buff, size_t size, const void* data){
+					glBindBuffer(GL_SHADER_STORAGE_BUFFER, buff);
+					glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, GL_DYNAMIC_COPY);
+				}
+				void SetStorageBufferData(HandleType buff, size_t offset, const void* data, size_t size){
+					glBindBuffer(GL_SHADER_STORAGE_BUFFER, buff);
+					glBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, size, data);
+				}
+				//Waits for everything, that writes the buffer
+				void GetStorageBufferData(HandleType buff, size_t offset, void* dest, size_t size){
+					glBindBuffer(GL_SHADER_STORAGE_BUFFER, buff);
+					glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, size, dest);
+				}
+				void BindStorageBuffer(uint32 binding_point, HandleType buff)
+					{ State::BindStorageBufferBase(binding_point, buff); }
+			}
+			namespace PreInit{
+				bool IsComputeSupported() { return false; }
+				void DispatchCompute(uint32 x, uint32 y, uint32 z) {}
+				void DispatchComputeIndirect(HandleType buff, size_t offset) {}
+				void InsertBarrier(uint32 barrier_bits) {}
+			}
+			bool (*IsComputeSupported)() = PreInit::IsComputeSupported;
+			void (*DispatchCompute)(uint32, uint32, uint32) = PreInit::DispatchCompute;
+			void (*DispatchComputeIndirect)(HandleType, size_t) = PreInit::DispatchComputeIndirect;
+			void (*InsertBarrier)(uint32) = PreInit::InsertBarrier;
+		}
+	}
+}
@@ -4,6 +4,7 @@
 #include <glad/glad.h>
 
 #include "../Common.h"
+#include "State.h"
 
 
 namespace LLJGFX{
@@ -17,6 +18,53 @@ namespace LLJGFX{
 			STENCIL_TEST
 		};
 	}
+
+	enum class BlendFactor{
+		ZERO,
+		ONE,
+		SRC_COLOR,
+		ONE_MINUS_SRC_COLOR,
+		DST_COLOR,
+		ONE_MINUS_DST_COLOR,
+		SRC_ALPHA,
+		ONE_MINUS_SRC_ALPHA,
+		DST_ALPHA,
+		ONE_MINUS_DST_ALPHA
+	};
+	enum class BlendOp{
+		ADD,
+		SUBTRACT,
+		REVERSE_SUBTRACT,
+		MIN,
+		MAX
+	};
+	enum class CompareFunc{
+		NEVER,
+		LESS,
+		EQUAL,
+		LESS_EQUAL,
+		GREATER,
+		NOT_EQUAL,
+		GREATER_EQUAL,
+		ALWAYS
+	};
+	enum class CullMode{
+		NONE,
+		BACK,
+		FRONT,
+		FRONT_AND_BACK
+	};
+	enum class StencilOp{
+		KEEP,
+		ZERO,
+		REPLACE,
+		INCREMENT,
+		INCREMENT_WRAP,
+		DECREMENT,
+		DECREMENT_WRAP,
+		INVERT
+	};
+
 	namespace Internal{
 		bool opt_modes[] = {
 				false, //blend
@@ -27,26 +75,80 @@ namespace LLJGFX{
 				false  //stencil_test
 		};
 		namespace Gpu{
+			constexpr GLenum opt_features[] = { GL_BLEND, GL_CULL_FACE, GL_DEPTH_CLAMP, GL_DEPTH_TEST,
+			                                    GL_SCISSOR_TEST, GL_STENCIL_TEST};
+			constexpr GLenum blend_factors[] = { GL_ZERO, GL_ONE, GL_SRC_COLOR, GL_ONE_MINUS_SRC_COLOR,
+			                                     GL_DST_COLOR, GL_ONE_MINUS_DST_COLOR, GL_SRC_ALPHA,
+			                                     GL_ONE_MINUS_SRC_ALPHA, GL_DST_ALPHA, GL_ONE_MINUS_DST_ALPHA };
+			constexpr GLenum blend_ops[] = { GL_FUNC_ADD, GL_FUNC_SUBTRACT, GL_FUNC_REVERSE_SUBTRACT, GL_MIN, GL_MAX };
+			constexpr GLenum compare_funcs[] = { GL_NEVER, GL_LESS, GL_EQUAL, GL_LEQUAL,
+			                                     GL_GREATER, GL_NOTEQUAL, GL_GEQUAL, GL_ALWAYS };
+			constexpr GLenum cull_faces[] = { GL_BACK, GL_BACK, GL_FRONT, GL_FRONT_AND_BACK };
+			constexpr GLenum stencil_ops[] = { GL_KEEP, GL_ZERO, GL_REPLACE, GL_INCR, GL_INCR_WRAP,
+			                                   GL_DECR, GL_DECR_WRAP, GL_INVERT };
+
+			//Everything is translated to GL values once, so applying it is only comparisons against the state cache
+			struct RasterState{
+				bool capabilities[State::CAPABILITY_COUNT] = {}; //Indexed by Opt::OptFtr
+				GLenum blend_func[4] = { GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA };
+				GLenum blend_equation = GL_FUNC_ADD;
+				GLenum depth_func = GL_LESS;
+				bool depth_write = true;
+				GLenum cull_face = GL_BACK;
+				GLint scissor[4] = { 0, 0, 0, 0 };
+				GLenum stencil_func = GL_ALWAYS;
+				GLint stencil_ref = 0;
+				GLuint stencil_read_mask = 0xFF;
+				GLenum stencil_op[3] = { GL_KEEP, GL_KEEP, GL_KEEP };
+				GLuint stencil_write_mask = 0xFF;
+				bool user_managed = false; //The scissor box and the stencil setup are left to whoever uses Opt
+			};
+
 			namespace Opengl33{
 				void Enable(Opt::OptFtr feature){
-					const GLenum features[] = { GL_BLEND, GL_CULL_FACE, GL_DEPTH_CLAMP, GL_DEPTH_TEST,
-					                            GL_SCISSOR_TEST, GL_STENCIL_TEST};
-
-					glEnable(features[(int32)feature]);
+					State::SetCapability(feature, opt_features[(int32)feature], true);
+					State::shadow.applied_pipeline = nullptr;
 				}
 				void Disable(Opt::OptFtr feature){
-					const GLenum features[] = { GL_BLEND, GL_CULL_FACE, GL_DEPTH_CLAMP, GL_DEPTH_TEST,
-					                            GL_SCISSOR_TEST, GL_STENCIL_TEST};
+					State::SetCapability(feature, opt_features[(int32)feature], false);
+					State::shadow.applied_pipeline = nullptr;
+				}
+				//"id" identifies the state object, applying the same one twice in a row costs a single comparison
+				void ApplyRasterState(const RasterState& st, const void* id){
+					if(id != nullptr && State::shadow.applied_pipeline == id) { State::frame_stats.skipped++; return; }
+
+					for(uint32 i = 0; i < State::CAPABILITY_COUNT; i++)
+						State::SetCapability(i, opt_features[i], st.capabilities[i]);
+
+					//The parameters of a disabled test don't matter, so they aren't touched
+					if(st.capabilities[Opt::BLEND]){
+						State::BlendFunc(st.blend_func[0], st.blend_func[1], st.blend_func[2], st.blend_func[3]);
+						State::BlendEquation(st.blend_equation);
+					}
+					if(st.capabilities[Opt::DEPTH_TEST]) State::DepthFunc(st.depth_func);
+					State::DepthMask(st.depth_write); //Affects clears too
+					if(st.capabilities[Opt::CULL]) State::CullFace(st.cull_face);
 
-					glDisable(features[(int32)feature]);
+					if(!st.user_managed){
+						if(st.capabilities[Opt::SCISSOR_TEST])
+							State::Scissor(st.scissor[0], st.scissor[1], st.scissor[2], st.scissor[3]);
+						if(st.capabilities[Opt::STENCIL_TEST]){
+							State::StencilFunc(st.stencil_func, st.stencil_ref, st.stencil_read_mask);
+							State::StencilOp(st.stencil_op[0], st.stencil_op[1], st.stencil_op[2]);
+							State::StencilMask(st.stencil_write_mask);
+						}
+					}
+					State::shadow.applied_pipeline = id;
 				}
 			}
 			namespace PreInit{
 				void Enable(Opt::OptFtr feature){}
 				void Disable(Opt::OptFtr feature){}
+				void ApplyRasterState(const RasterState& st, const void* id){}
 			}
 			void(*Enable)(Opt::OptFtr feature) = PreInit::Enable;
 			void(*Disable)(Opt::OptFtr feature) = PreInit::Disable;
+			void(*ApplyRasterState)(const RasterState& st, const void* id) = PreInit::ApplyRasterState;
 		}
 	}
 }
\ No newline at end of file
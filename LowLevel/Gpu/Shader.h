@@ -1,9 +1,12 @@
 #pragma once
 #include <string>
 #include <stdexcept>
+#include <unordered_map>
+#include <vector>
 #include <glad/glad.h>
 
 #include "../Common.h"
+#include "State.h"
 
 
 namespace LLJGFX{
@@ -11,7 +14,8 @@ namespace LLJGFX{
 		namespace Gpu{
 			enum class ShaderType {
 				VERTEX,
-				FRAGMENT
+				FRAGMENT,
+				COMPUTE //GL 4.3 or ARB_compute_shader
 			};
 
 			enum class UniformType {
@@ -109,6 +113,105 @@ namespace LLJGFX{
 				sizeof(glm::mat4x4)
 			};
 
+			//GL_FLOAT_MAT2x3 is 2 columns of 3, like glm::mat2x3
+			inline UniformType TranslateUniformType(GLenum gl_type){
+				switch(gl_type){
+					case GL_UNSIGNED_INT: return UniformType::UINT32;
+					case GL_INT: return UniformType::INT32;
+					case GL_FLOAT: return UniformType::FL32;
+
+					case GL_UNSIGNED_INT_VEC2: return UniformType::VEC2_UINT32;
+					case GL_INT_VEC2: return UniformType::VEC2_INT32;
+					case GL_FLOAT_VEC2: return UniformType::VEC2_FL32;
+
+					case GL_UNSIGNED_INT_VEC3: return UniformType::VEC3_UINT32;
+					case GL_INT_VEC3: return UniformType::VEC3_INT32;
+					case GL_FLOAT_VEC3: return UniformType::VEC3_FL32;
+
+					case GL_UNSIGNED_INT_VEC4: return UniformType::VEC4_UINT32;
+					case GL_INT_VEC4: return UniformType::VEC4_INT32;
+					case GL_FLOAT_VEC4: return UniformType::VEC4_FL32;
+
+					case GL_FLOAT_MAT2: return UniformType::MAT2x2;
+					case GL_FLOAT_MAT2x3: return UniformType::MAT2x3;
+					case GL_FLOAT_MAT2x4: return UniformType::MAT2x4;
+
+					case GL_FLOAT_MAT3x2: return UniformType::MAT3x2;
+					case GL_FLOAT_MAT3: return UniformType::MAT3x3;
+					case GL_FLOAT_MAT3x4: return UniformType::MAT3x4;
+
+					case GL_FLOAT_MAT4x2: return UniformType::MAT4x2;
+					case GL_FLOAT_MAT4x3: return UniformType::MAT4x3;
+					case GL_FLOAT_MAT4: return UniformType::MAT4x4;
+					default: return UniformType::INVALID; //Samplers, bools, doubles
+				}
+			}
+			inline bool IsSamplerType(GLenum gl_type){
+				switch(gl_type){
+					case GL_SAMPLER_1D: case GL_SAMPLER_2D: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE:
+					case GL_SAMPLER_1D_SHADOW: case GL_SAMPLER_2D_SHADOW: case GL_SAMPLER_CUBE_SHADOW:
+					case GL_SAMPLER_1D_ARRAY: case GL_SAMPLER_2D_ARRAY: case GL_SAMPLER_1D_ARRAY_SHADOW: case GL_SAMPLER_2D_ARRAY_SHADOW:
+					case GL_SAMPLER_2D_MULTISAMPLE: case GL_SAMPLER_2D_MULTISAMPLE_ARRAY: case GL_SAMPLER_BUFFER:
+					case GL_SAMPLER_2D_RECT: case GL_SAMPLER_2D_RECT_SHADOW:
+					case GL_INT_SAMPLER_1D: case GL_INT_SAMPLER_2D: case GL_INT_SAMPLER_3D: case GL_INT_SAMPLER_CUBE:
+					case GL_INT_SAMPLER_1D_ARRAY: case GL_INT_SAMPLER_2D_ARRAY: case GL_INT_SAMPLER_2D_MULTISAMPLE:
+					case GL_INT_SAMPLER_2D_MULTISAMPLE_ARRAY: case GL_INT_SAMPLER_BUFFER: case GL_INT_SAMPLER_2D_RECT:
+					case GL_UNSIGNED_INT_SAMPLER_1D: case GL_UNSIGNED_INT_SAMPLER_2D: case GL_UNSIGNED_INT_SAMPLER_3D:
+					case GL_UNSIGNED_INT_SAMPLER_CUBE: case GL_UNSIGNED_INT_SAMPLER_1D_ARRAY: case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+					case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE: case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE_ARRAY:
+					case GL_UNSIGNED_INT_SAMPLER_BUFFER: case GL_UNSIGNED_INT_SAMPLER_2D_RECT:
+						return true;
+					default: return false;
+				}
+			}
+			//Components of a vertex attribute type(columns of a matrix take a location each and aren't counted)
+			inline uint32 GetAttributeComponentCount(GLenum gl_type){
+				switch(gl_type){
+					case GL_FLOAT: case GL_INT: case GL_UNSIGNED_INT: case GL_DOUBLE: return 1;
+					case GL_FLOAT_VEC2: case GL_INT_VEC2: case GL_UNSIGNED_INT_VEC2: case GL_FLOAT_MAT2: case GL_FLOAT_MAT3x2: case GL_FLOAT_MAT4x2: return 2;
+					case GL_FLOAT_VEC3: case GL_INT_VEC3: case GL_UNSIGNED_INT_VEC3: case GL_FLOAT_MAT3: case GL_FLOAT_MAT2x3: case GL_FLOAT_MAT4x3: return 3;
+					default: return 4;
+				}
+			}
+			inline bool IsIntegerAttributeType(GLenum gl_type){
+				switch(gl_type){
+					case GL_INT: case GL_INT_VEC2: case GL_INT_VEC3: case GL_INT_VEC4:
+					case GL_UNSIGNED_INT: case GL_UNSIGNED_INT_VEC2: case GL_UNSIGNED_INT_VEC3: case GL_UNSIGNED_INT_VEC4:
+						return true;
+					default: return false;
+				}
+			}
+		}
+	}
+
+	//What the linker reports about a program. Built once per link
+	struct ShaderVariable{
+		std::string name; //Arrays are reported as "name[0]"
+		uint32 gl_type = 0; //GL_FLOAT_VEC3, GL_SAMPLER_2D...
+		Internal::Gpu::UniformType type = Internal::Gpu::UniformType::INVALID; //INVALID for samplers and attributes
+		int32 array_size = 1;
+		int32 location = -1;
+	};
+	struct ShaderSampler{
+		std::string name;
+		uint32 gl_type = 0;
+		int32 location = -1;
+		int32 unit = 0; //Texture slot the sampler reads from at the time of the link
+	};
+	struct ShaderBlock{
+		std::string name;
+		uint32 index = 0;
+		uint32 data_size = 0;
+	};
+	struct ProgramReflection{
+		std::vector<ShaderVariable> uniforms; //Including samplers, without members of uniform blocks
+		std::vector<ShaderSampler> samplers;
+		std::vector<ShaderBlock> blocks;
+		std::vector<ShaderVariable> attributes; //Built-ins(gl_VertexID...) are skipped
+	};
+
+	namespace Internal{
+		namespace Gpu{
 			namespace Opengl33{
 				namespace Uniforms {
 					using UniformFuncPtr = void (*)(int uniform_location, int count, const void* value);
@@ -174,16 +277,13 @@ namespace LLJGFX{
 				HandleType bound_shader = INVALID_HANDLE;
 
 				HandleType MakeShader(ShaderType type) {
-					const GLenum sh_types[] = {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER};
+					const GLenum sh_types[] = {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_COMPUTE_SHADER};
 					return glCreateShader(sh_types[(int32)type]);
 				}
 				void DeleteShader(HandleType handle) { glDeleteShader(handle); }
-				void CompileShader(HandleType handle, const std::string& source){
-					const char *tmp = source.c_str();
-					const GLint size = source.size();
-					glShaderSource(handle, 1, &tmp, &size);
-					glCompileShader(handle);
-#ifndef NDEBUG
+
+				//Querying a status waits for the driver, so the checks are separate from issuing the work
+				void CheckShaderCompileStatus(HandleType handle){
 					char deb_log[1024];
 					int success = 0;
 					glGetShaderiv(handle, GL_COMPILE_STATUS, &success);
@@ -191,36 +291,211 @@ namespace LLJGFX{
 						glGetShaderInfoLog(handle, 1024, nullptr, deb_log);
 						throw std::runtime_error(std::string("Shader compilation failed: " + std::string(deb_log)).c_str());
 					}
+				}
+				void CheckProgramLinkStatus(HandleType program_handle){
+					char deb_log[1024];
+					int success = 0;
+					glGetProgramiv(program_handle, GL_LINK_STATUS, &success);
+					if (!success) {
+						glGetProgramInfoLog(program_handle, 1024, nullptr, deb_log);
+						throw std::runtime_error(std::string("Shader program linking failed: " + std::string(deb_log)).c_str());
+					}
+				}
+
+				void CompileShaderAsync(HandleType handle, const std::string& source){
+					const char *tmp = source.c_str();
+					const GLint size = source.size();
+					glShaderSource(handle, 1, &tmp, &size);
+					glCompileShader(handle);
+				}
+				void CompileShader(HandleType handle, const std::string& source){
+					CompileShaderAsync(handle, source);
+#ifndef NDEBUG
+					CheckShaderCompileStatus(handle);
 #endif
 				}
 
 				HandleType MakeShaderProgram() { return glCreateProgram(); }
-				void DeleteShaderProgram(HandleType handle) { glDeleteProgram(handle); }
-				void LinkShaderProgram(HandleType program_handle, HandleType v_sh_handle, HandleType f_sh_handle){
+				void DeleteShaderProgram(HandleType handle) { glDeleteProgram(handle); State::ForgetProgram(handle); }
+				void LinkShaderProgramAsync(HandleType program_handle, HandleType v_sh_handle, HandleType f_sh_handle){
 					glAttachShader(program_handle, v_sh_handle);
 					glAttachShader(program_handle, f_sh_handle);
 					glLinkProgram(program_handle);
+				}
+				void LinkShaderProgram(HandleType program_handle, HandleType v_sh_handle, HandleType f_sh_handle){
+					LinkShaderProgramAsync(program_handle, v_sh_handle, f_sh_handle);
 #ifndef NDEBUG
-					char deb_log[1024];
-					int success = 0;
+					CheckProgramLinkStatus(program_handle);
+#endif
+				}
+				//Must be called before linking. Interleaved puts every varying into one buffer, separate gives each its own
+				void SetFeedbackVaryings(HandleType program_handle, const std::vector<std::string>& varyings, bool interleaved){
+					std::vector<const char*> names;
+					names.reserve(varyings.size());
+					for(const std::string& i : varyings) names.push_back(i.c_str());
+					glTransformFeedbackVaryings(program_handle, (GLsizei)names.size(), names.data(),
+					                            interleaved ? GL_INTERLEAVED_ATTRIBS : GL_SEPARATE_ATTRIBS);
+				}
+				void LinkComputeProgramAsync(HandleType program_handle, HandleType c_sh_handle){
+					glAttachShader(program_handle, c_sh_handle);
+					glLinkProgram(program_handle);
+				}
+				void LinkComputeProgram(HandleType program_handle, HandleType c_sh_handle){
+					LinkComputeProgramAsync(program_handle, c_sh_handle);
+#ifndef NDEBUG
+					CheckProgramLinkStatus(program_handle);
+#endif
+				}
+
+				//KHR/ARB_parallel_shader_compile let the driver compile on its own threads and be polled without waiting
+				bool parallel_compile = false;
+				bool EnableParallelCompile(){
+					if(GLAD_GL_KHR_parallel_shader_compile) glMaxShaderCompilerThreadsKHR(0xFFFFFFFF); //As many as the driver wants
+					else if(GLAD_GL_ARB_parallel_shader_compile) glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+					parallel_compile = GLAD_GL_KHR_parallel_shader_compile || GLAD_GL_ARB_parallel_shader_compile;
+					return parallel_compile;
+				}
+				//Without the extension there is no way to ask without waiting, so it's reported as done
+				bool IsProgramLinkComplete(HandleType program_handle){
+					if(!parallel_compile) return true;
+					GLint done = 0;
+					glGetProgramiv(program_handle, GL_COMPLETION_STATUS_KHR, &done);
+					return done;
+				}
+				//Waits for the link of an async built program
+				void FinishProgramLink(HandleType program_handle, HandleType v_sh_handle, HandleType f_sh_handle){
+#ifndef NDEBUG
+					GLint success = 0;
 					glGetProgramiv(program_handle, GL_LINK_STATUS, &success);
-					if (!success) {
-						glGetProgramInfoLog(program_handle, 1024, nullptr, deb_log);
-						throw std::runtime_error(std::string("Shader program linking failed: " + std::string(deb_log)).c_str());
+					if(!success){ //The shader logs say more than the link log
+						CheckShaderCompileStatus(v_sh_handle);
+						CheckShaderCompileStatus(f_sh_handle);
+						CheckProgramLinkStatus(program_handle);
 					}
 #endif
 				}
 
+				//The program is left bound, every draw binds the program it needs through the state cache anyway
 				void SetUniform(HandleType prg, const std::string& u_name, UniformType type, const void* data, size_t elem_count) {
-					glUseProgram(prg);
+					State::UseProgram(prg);
 
 					const GLint loc = glGetUniformLocation(prg, u_name.c_str());
 					Uniforms::GetUniformFunction(type)(loc, (GLint)elem_count, data);
+				}
+				//Same, but with an already known location. The name is needed only before the initialization
+				void SetUniformAt(HandleType prg, int32 location, const std::string& u_name, UniformType type,
+				                  const void* data, size_t elem_count) {
+					State::UseProgram(prg);
+					Uniforms::GetUniformFunction(type)(location, (GLint)elem_count, data);
+				}
 
-					glUseProgram(bound_shader);
+				int32 GetUniformLocation(HandleType prg, const std::string& u_name)
+					{ return glGetUniformLocation(prg, u_name.c_str()); }
+				//Reads one element, "data" must have room for type_size_table[type] bytes
+				void GetUniformValue(HandleType prg, int32 location, UniformType type, void* data){
+					if(type >= UniformType::MAT2x2) { glGetUniformfv(prg, location, (GLfloat*)data); return; }
+					switch((int32)type % 3){ //The vector types go uint, int, float
+						case 0: glGetUniformuiv(prg, location, (GLuint*)data); break;
+						case 1: glGetUniformiv(prg, location, (GLint*)data); break;
+						default: glGetUniformfv(prg, location, (GLfloat*)data); break;
+					}
 				}
+				//Does nothing, if the program doesn't declare the block
+				void BindUniformBlock(HandleType prg, const std::string& block_name, uint32 binding_point){
+					const GLuint block_id = glGetUniformBlockIndex(prg, block_name.c_str());
+					if(block_id != GL_INVALID_INDEX) glUniformBlockBinding(prg, block_id, binding_point);
+				}
+				//Queries the interface of a linked program
+				void QueryProgramReflection(HandleType prg, ProgramReflection& reflection){
+					reflection = {};
+					GLint count = 0;
+					GLint max_length = 0;
+					glGetProgramiv(prg, GL_ACTIVE_UNIFORMS, &count);
+					glGetProgramiv(prg, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+
+					std::string name(max_length, '\0');
+					for(GLint i = 0; i < count; i++){
+						GLsizei length = 0;
+						GLint size = 0;
+						GLenum type = 0;
+						glGetActiveUniform(prg, i, max_length, &length, &size, &type, name.data());
+
+						const std::string uf_name = name.substr(0, length);
+						const GLint loc = glGetUniformLocation(prg, uf_name.c_str());
+						if(loc == -1) continue; //Members of uniform blocks
+
+						reflection.uniforms.push_back({uf_name, type, TranslateUniformType(type), size, loc});
+						if(IsSamplerType(type)){
+							GLint unit = 0;
+							glGetUniformiv(prg, loc, &unit);
+							reflection.samplers.push_back({uf_name, type, loc, unit});
+						}
+					}
+
+					glGetProgramiv(prg, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+					for(GLint i = 0; i < count; i++){
+						GLint length = 0;
+						GLint data_size = 0;
+						glGetActiveUniformBlockiv(prg, i, GL_UNIFORM_BLOCK_NAME_LENGTH, &length);
+						glGetActiveUniformBlockiv(prg, i, GL_UNIFORM_BLOCK_DATA_SIZE, &data_size);
+
+						std::string block_name(length, '\0');
+						glGetActiveUniformBlockName(prg, i, length, &length, block_name.data());
+						block_name.resize(length);
+						reflection.blocks.push_back({block_name, (uint32)i, (uint32)data_size});
+					}
 
-				void BindSP(HandleType prg){ bound_shader = prg; glUseProgram(prg); }
+					glGetProgramiv(prg, GL_ACTIVE_ATTRIBUTES, &count);
+					glGetProgramiv(prg, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &max_length);
+					name.assign(max_length, '\0');
+					for(GLint i = 0; i < count; i++){
+						GLsizei length = 0;
+						GLint size = 0;
+						GLenum type = 0;
+						glGetActiveAttrib(prg, i, max_length, &length, &size, &type, name.data());
+
+						const std::string attr_name = name.substr(0, length);
+						const GLint loc = glGetAttribLocation(prg, attr_name.c_str());
+						if(loc == -1) continue;
+						reflection.attributes.push_back({attr_name, type, UniformType::INVALID, size, loc});
+					}
+				}
+
+				void BindSP(HandleType prg){ bound_shader = prg; State::UseProgram(prg); }
+
+				//Program binaries(GL 4.1 or ARB_get_program_binary)
+				bool IsProgramBinarySupported(){
+					if(!GLAD_GL_VERSION_4_1 && !GLAD_GL_ARB_get_program_binary) return false;
+					GLint format_count = 0;
+					glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+					return format_count > 0;
+				}
+				//Binaries of the same source are valid only for the same driver
+				std::string GetDriverString(){
+					const auto get = [](GLenum name){ const GLubyte* str = glGetString(name); return str != nullptr ? std::string((const char*)str) : std::string(); };
+					return get(GL_VENDOR) + '|' + get(GL_RENDERER) + '|' + get(GL_VERSION);
+				}
+				//Must be called before linking
+				void SetProgramBinaryRetrievable(HandleType prg)
+					{ glProgramParameteri(prg, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE); }
+				bool GetProgramBinary(HandleType prg, uint32& format, std::string& binary){
+					GLint length = 0;
+					glGetProgramiv(prg, GL_PROGRAM_BINARY_LENGTH, &length);
+					if(length <= 0) return false;
+
+					GLenum gl_format = 0;
+					binary.resize(length);
+					glGetProgramBinary(prg, length, nullptr, &gl_format, binary.data());
+					format = gl_format;
+					return true;
+				}
+				//The driver can reject a binary(e.g. after an update), then the program has to be built from source
+				bool LoadProgramBinary(HandleType prg, uint32 format, const std::string& binary){
+					glProgramBinary(prg, format, binary.data(), (GLsizei)binary.size());
+					GLint success = 0;
+					glGetProgramiv(prg, GL_LINK_STATUS, &success);
+					return success;
+				}
 			}
 			namespace PreInit{
 				HandleType sh_last_handle = 1;
@@ -243,10 +518,30 @@ namespace LLJGFX{
 				HandleType MakeShaderProgram() { pi_sps[sh_last_handle]; return sh_last_handle++; }
 				void DeleteShaderProgram(HandleType handle) { pi_sps.erase(handle); }
 				void LinkShaderProgram(HandleType program_handle, HandleType vertex_sh_handle, HandleType fragment_sh_handle){}
+				void LinkComputeProgram(HandleType program_handle, HandleType compute_sh_handle){}
+				void SetFeedbackVaryings(HandleType program_handle, const std::vector<std::string>& varyings, bool interleaved){}
+
+				bool EnableParallelCompile() { return false; }
+				bool IsProgramLinkComplete(HandleType program_handle) { return false; }
+				void FinishProgramLink(HandleType program_handle, HandleType v_sh_handle, HandleType f_sh_handle) {}
 
 				void SetUniform(HandleType prg, const std::string& u_name, UniformType type, const void* data, size_t elem_count){
 					pi_sps.find(prg)->second.uniforms[u_name] = {type, std::string((const char*)data, type_size_table[(int32)type] * elem_count)};
 				}
+				void SetUniformAt(HandleType prg, int32 location, const std::string& u_name, UniformType type,
+				                  const void* data, size_t elem_count)
+					{ SetUniform(prg, u_name, type, data, elem_count); }
+
+				int32 GetUniformLocation(HandleType prg, const std::string& u_name) { return -1; }
+				void GetUniformValue(HandleType prg, int32 location, UniformType type, void* data) {}
+				void BindUniformBlock(HandleType prg, const std::string& block_name, uint32 binding_point){}
+				void QueryProgramReflection(HandleType prg, ProgramReflection& reflection) { reflection = {}; }
+
+				bool IsProgramBinarySupported() { return false; }
+				std::string GetDriverString() { return {}; }
+				void SetProgramBinaryRetrievable(HandleType prg) {}
+				bool GetProgramBinary(HandleType prg, uint32& format, std::string& binary) { return false; }
+				bool LoadProgramBinary(HandleType prg, uint32 format, const std::string& binary) { return false; }
 			}
 			HandleType (*MakeShader)(ShaderType) = PreInit::MakeShader;
 			void (*DeleteShader)(HandleType) = PreInit::DeleteShader;
@@ -255,10 +550,32 @@ namespace LLJGFX{
 			HandleType (*MakeShaderProgram)() = PreInit::MakeShaderProgram;
 			void (*DeleteShaderProgram)(HandleType) = PreInit::DeleteShaderProgram;
 			void (*LinkShaderProgram)(HandleType, HandleType, HandleType) = PreInit::LinkShaderProgram;
+			void (*LinkComputeProgram)(HandleType, HandleType) = PreInit::LinkComputeProgram;
+			void (*SetFeedbackVaryings)(HandleType, const std::vector<std::string>&, bool) = PreInit::SetFeedbackVaryings;
+
+			//The async versions don't check anything, FinishProgramLink() does
+			void (*CompileShaderAsync)(HandleType, const std::string&) = PreInit::CompileShader;
+			void (*LinkShaderProgramAsync)(HandleType, HandleType, HandleType) = PreInit::LinkShaderProgram;
+			void (*LinkComputeProgramAsync)(HandleType, HandleType) = PreInit::LinkComputeProgram;
+			bool (*EnableParallelCompile)() = PreInit::EnableParallelCompile;
+			bool (*IsProgramLinkComplete)(HandleType prg) = PreInit::IsProgramLinkComplete;
+			void (*FinishProgramLink)(HandleType prg, HandleType v_sh_handle, HandleType f_sh_handle) = PreInit::FinishProgramLink;
 
 			void (*SetUniform)(HandleType prg, const std::string& u_name, UniformType type, const void* data, size_t elem_count) = PreInit::SetUniform;
+			void (*SetUniformAt)(HandleType prg, int32 location, const std::string& u_name, UniformType type,
+			                     const void* data, size_t elem_count) = PreInit::SetUniformAt;
+			int32 (*GetUniformLocation)(HandleType prg, const std::string& u_name) = PreInit::GetUniformLocation;
+			void (*GetUniformValue)(HandleType prg, int32 location, UniformType type, void* data) = PreInit::GetUniformValue;
+			void (*BindUniformBlock)(HandleType prg, const std::string& block_name, uint32 binding_point) = PreInit::BindUniformBlock;
+			void (*QueryProgramReflection)(HandleType prg, ProgramReflection& reflection) = PreInit::QueryProgramReflection;
 
 			void (*BindShaderProgram)(HandleType prg) = Opengl33::BindSP;
+
+			bool (*IsProgramBinarySupported)() = PreInit::IsProgramBinarySupported;
+			std::string (*GetDriverString)() = PreInit::GetDriverString;
+			void (*SetProgramBinaryRetrievable)(HandleType prg) = PreInit::SetProgramBinaryRetrievable;
+			bool (*GetProgramBinary)(HandleType prg, uint32& format, std::string& binary) = PreInit::GetProgramBinary;
+			bool (*LoadProgramBinary)(HandleType prg, uint32 format, const std::string& binary) = PreInit::LoadProgramBinary;
 		}
 	}
 }
\ No newline at end of file
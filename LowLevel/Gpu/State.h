@@ -0,0 +1,250 @@
+#pragma once
+#include <mutex>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "../Common.h"
+
+namespace LLJGFX{
+	struct StateCacheStats{
+		uint64 issued = 0; //Calls that actually reached the driver
+		uint64 skipped = 0; //Calls that were dropped, because they wouldn't change anything
+	};
+
+	namespace Internal{
+		namespace Gpu{
+			namespace State{
+				//Shadow copy of the binding state of the current context.
+				//Every binding in the low level layer must go through here, otherwise the shadow gets out of sync.
+				//Like the context, all of it is per thread
+				constexpr HandleType UNKNOWN = (HandleType)-1;
+				constexpr uint32 TEXTURE_UNIT_COUNT = 32;
+				constexpr uint32 CAPABILITY_COUNT = 6; //Same order as Opt::OptFtr
+				constexpr uint32 UNIFORM_BUFFER_BINDING_COUNT = 36; //The minimum GL 3.3 guarantees
+				constexpr uint32 STORAGE_BUFFER_BINDING_COUNT = 8; //The minimum GL 4.3 guarantees, higher ones aren't cached
+
+				struct Shadow{
+					uint32 active_texture_unit = UNKNOWN;
+					HandleType textures[TEXTURE_UNIT_COUNT];
+					HandleType program = UNKNOWN;
+					HandleType vertex_array = UNKNOWN;
+					HandleType array_buffer = UNKNOWN;
+					HandleType element_buffer = UNKNOWN; //Part of the VAO state, so it's reset on every VAO change
+					HandleType framebuffer = UNKNOWN;
+					HandleType uniform_buffers[UNIFORM_BUFFER_BINDING_COUNT];
+					HandleType storage_buffers[STORAGE_BUFFER_BINDING_COUNT];
+					pos2du16 viewport = {0, 0};
+					bool viewport_known = false;
+
+					//Raster state, -1 in a bool field means "unknown"
+					int8 capabilities[CAPABILITY_COUNT];
+					GLenum blend_func[4] = { UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN };
+					GLenum blend_equation = UNKNOWN;
+					GLenum depth_func = UNKNOWN;
+					int8 depth_mask = -1;
+					GLenum cull_face = UNKNOWN;
+					GLint scissor[4] = { 0, 0, 0, 0 };
+					bool scissor_known = false;
+					GLenum stencil_func = UNKNOWN;
+					GLint stencil_ref = 0;
+					GLuint stencil_read_mask = 0;
+					GLenum stencil_op[3] = { UNKNOWN, UNKNOWN, UNKNOWN };
+					GLuint stencil_write_mask = 0;
+					bool stencil_write_mask_known = false;
+					const void* applied_pipeline = nullptr; //Lets a pipeline, that is applied again, skip the whole comparison
+
+					Shadow() {
+						for(HandleType& i : textures) i = UNKNOWN;
+						for(HandleType& i : uniform_buffers) i = UNKNOWN;
+						for(HandleType& i : storage_buffers) i = UNKNOWN;
+						for(int8& i : capabilities) i = -1;
+					}
+				};
+
+				thread_local Shadow shadow;
+				thread_local GLFWwindow* current_window = nullptr;
+
+				thread_local StateCacheStats frame_stats;
+				//Written by the presenting thread(the render thread, if it runs), read by the application
+				StateCacheStats last_frame_stats;
+				std::mutex last_frame_stats_mutex;
+
+				inline bool Changed(bool changed){
+					if(changed) frame_stats.issued++;
+					else frame_stats.skipped++;
+					return changed;
+				}
+
+				inline void Invalidate() { shadow = {}; }
+
+				inline void MakeContextCurrent(GLFWwindow* win){
+					if(!Changed(current_window != win)) return;
+					glfwMakeContextCurrent(win);
+					current_window = win;
+					Invalidate(); //Binding state is per context
+				}
+
+				inline void ActiveTexture(uint32 unit){
+					if(!Changed(shadow.active_texture_unit != unit)) return;
+					glActiveTexture(GL_TEXTURE0 + unit);
+					shadow.active_texture_unit = unit;
+				}
+				inline void BindTextureUnit(uint32 unit, HandleType txt){
+					if(shadow.textures[unit] == txt) { frame_stats.skipped++; return; }
+					ActiveTexture(unit);
+					glBindTexture(GL_TEXTURE_2D, txt);
+					frame_stats.issued++;
+					shadow.textures[unit] = txt;
+				}
+				//Binds to whatever unit is active, the same way a raw glBindTexture would
+				inline void BindTexture(HandleType txt){
+					if(shadow.active_texture_unit == UNKNOWN) ActiveTexture(0);
+					BindTextureUnit(shadow.active_texture_unit, txt);
+				}
+
+				inline void UseProgram(HandleType prg){
+					if(!Changed(shadow.program != prg)) return;
+					glUseProgram(prg);
+					shadow.program = prg;
+				}
+				inline void BindVertexArray(HandleType vao){
+					if(!Changed(shadow.vertex_array != vao)) return;
+					glBindVertexArray(vao);
+					shadow.vertex_array = vao;
+					shadow.element_buffer = UNKNOWN;
+				}
+				inline void BindArrayBuffer(HandleType buff){
+					if(!Changed(shadow.array_buffer != buff)) return;
+					glBindBuffer(GL_ARRAY_BUFFER, buff);
+					shadow.array_buffer = buff;
+				}
+				inline void BindElementBuffer(HandleType buff){
+					if(!Changed(shadow.element_buffer != buff)) return;
+					glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buff);
+					shadow.element_buffer = buff;
+				}
+				inline void BindUniformBufferBase(uint32 binding_point, HandleType buff){
+					if(!Changed(shadow.uniform_buffers[binding_point] != buff)) return;
+					glBindBufferBase(GL_UNIFORM_BUFFER, binding_point, buff);
+					shadow.uniform_buffers[binding_point] = buff;
+				}
+				inline void BindStorageBufferBase(uint32 binding_point, HandleType buff){
+					if(binding_point < STORAGE_BUFFER_BINDING_COUNT){
+						if(!Changed(shadow.storage_buffers[binding_point] != buff)) return;
+						shadow.storage_buffers[binding_point] = buff;
+					}
+					glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding_point, buff);
+				}
+				inline void BindFramebuffer(HandleType fb){
+					if(!Changed(shadow.framebuffer != fb)) return;
+					FlushPendingBatches(); //They were recorded for the old target
+					glBindFramebuffer(GL_FRAMEBUFFER, fb);
+					shadow.framebuffer = fb;
+				}
+				inline void Viewport(pos2du16 size){
+					if(!Changed(!shadow.viewport_known || shadow.viewport != size)) return;
+					glViewport(0, 0, size.x, size.y);
+					shadow.viewport = size;
+					shadow.viewport_known = true;
+				}
+
+				inline void SetCapability(uint32 id, GLenum capability, bool enabled){
+					if(!Changed(shadow.capabilities[id] != (int8)enabled)) return;
+					if(enabled) glEnable(capability);
+					else glDisable(capability);
+					shadow.capabilities[id] = (int8)enabled;
+				}
+				inline void BlendFunc(GLenum src_color, GLenum dst_color, GLenum src_alpha, GLenum dst_alpha){
+					if(!Changed(shadow.blend_func[0] != src_color || shadow.blend_func[1] != dst_color ||
+					            shadow.blend_func[2] != src_alpha || shadow.blend_func[3] != dst_alpha)) return;
+					glBlendFuncSeparate(src_color, dst_color, src_alpha, dst_alpha);
+					shadow.blend_func[0] = src_color; shadow.blend_func[1] = dst_color;
+					shadow.blend_func[2] = src_alpha; shadow.blend_func[3] = dst_alpha;
+				}
+				inline void BlendEquation(GLenum equation){
+					if(!Changed(shadow.blend_equation != equation)) return;
+					glBlendEquation(equation);
+					shadow.blend_equation = equation;
+				}
+				inline void DepthFunc(GLenum func){
+					if(!Changed(shadow.depth_func != func)) return;
+					glDepthFunc(func);
+					shadow.depth_func = func;
+				}
+				inline void DepthMask(bool write){
+					if(!Changed(shadow.depth_mask != (int8)write)) return;
+					glDepthMask(write ? GL_TRUE : GL_FALSE);
+					shadow.depth_mask = (int8)write;
+				}
+				inline void CullFace(GLenum face){
+					if(!Changed(shadow.cull_face != face)) return;
+					glCullFace(face);
+					shadow.cull_face = face;
+				}
+				inline void Scissor(GLint x, GLint y, GLint width, GLint height){
+					if(!Changed(!shadow.scissor_known || shadow.scissor[0] != x || shadow.scissor[1] != y ||
+					            shadow.scissor[2] != width || shadow.scissor[3] != height)) return;
+					glScissor(x, y, width, height);
+					shadow.scissor[0] = x; shadow.scissor[1] = y; shadow.scissor[2] = width; shadow.scissor[3] = height;
+					shadow.scissor_known = true;
+				}
+				inline void StencilFunc(GLenum func, GLint ref, GLuint read_mask){
+					if(!Changed(shadow.stencil_func != func || shadow.stencil_ref != ref ||
+					            shadow.stencil_read_mask != read_mask)) return;
+					glStencilFunc(func, ref, read_mask);
+					shadow.stencil_func = func;
+					shadow.stencil_ref = ref;
+					shadow.stencil_read_mask = read_mask;
+				}
+				inline void StencilOp(GLenum stencil_fail, GLenum depth_fail, GLenum pass){
+					if(!Changed(shadow.stencil_op[0] != stencil_fail || shadow.stencil_op[1] != depth_fail ||
+					            shadow.stencil_op[2] != pass)) return;
+					glStencilOp(stencil_fail, depth_fail, pass);
+					shadow.stencil_op[0] = stencil_fail; shadow.stencil_op[1] = depth_fail; shadow.stencil_op[2] = pass;
+				}
+				inline void StencilMask(GLuint write_mask){
+					if(!Changed(!shadow.stencil_write_mask_known || shadow.stencil_write_mask != write_mask)) return;
+					glStencilMask(write_mask);
+					shadow.stencil_write_mask = write_mask;
+					shadow.stencil_write_mask_known = true;
+				}
+
+				//Deleting an object makes GL fall back to 0 for every binding it had, so the shadow has to follow
+				inline void ForgetTexture(HandleType txt){
+					for(HandleType& i : shadow.textures)
+						if(i == txt) i = 0;
+				}
+				inline void ForgetProgram(HandleType prg)
+					{ if(shadow.program == prg) shadow.program = UNKNOWN; }
+				inline void ForgetVertexArray(HandleType vao)
+					{ if(shadow.vertex_array == vao) { shadow.vertex_array = 0; shadow.element_buffer = UNKNOWN; } }
+				inline void ForgetBuffer(HandleType buff){
+					if(shadow.array_buffer == buff) shadow.array_buffer = 0;
+					if(shadow.element_buffer == buff) shadow.element_buffer = 0;
+					for(HandleType& i : shadow.uniform_buffers)
+						if(i == buff) i = 0;
+					for(HandleType& i : shadow.storage_buffers)
+						if(i == buff) i = 0;
+				}
+				inline void ForgetFramebuffer(HandleType fb)
+					{ if(shadow.framebuffer == fb) shadow.framebuffer = 0; }
+				inline void ForgetPipeline(const void* pipeline)
+					{ if(shadow.applied_pipeline == pipeline) shadow.applied_pipeline = nullptr; }
+
+				inline void EndFrame(){
+					{
+						std::lock_guard<std::mutex> lock(last_frame_stats_mutex);
+						last_frame_stats = frame_stats;
+					}
+					frame_stats = {};
+				}
+			}
+		}
+	}
+
+	//Stats of the last finished frame(they are collected between two NewFrame() calls)
+	inline StateCacheStats GetStateCacheStats(){
+		std::lock_guard<std::mutex> lock(Internal::Gpu::State::last_frame_stats_mutex);
+		return Internal::Gpu::State::last_frame_stats;
+	}
+}
@@ -2,8 +2,11 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <cstring>
+#include <algorithm>
 
 #include "../Common.h"
+#include "State.h"
+#include "Draw.h"
 
 namespace JGFX{
 	constexpr unsigned char PIXEL_BINARY_SIZE = 4;
@@ -31,25 +34,51 @@ namespace LLJGFX {
 					return handle;
 				}
 				void DeleteTexture(HandleType txt_handle)
-					{ glDeleteTextures(1, &txt_handle);}
+					{ glDeleteTextures(1, &txt_handle); State::ForgetTexture(txt_handle); }
 				void SetTextureData(HandleType txt_handle, const uint8* data, pos2du16 size){
-					glBindTexture(GL_TEXTURE_2D, txt_handle);
+					State::BindTexture(txt_handle);
 					glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size.x, size.y, 0,
 					             GL_RGBA, GL_UNSIGNED_BYTE, data);
 				}
+				//"row_length" is the width of the whole source image in pixels, so a part of it can be uploaded as it is
+				void SetTextureSubData(HandleType txt_handle, pos2du16 txt_size, pos2du16 offset, pos2du16 size,
+				                       const uint8* data, uint32 row_length){
+					State::BindTexture(txt_handle);
+					if(row_length != size.x) glPixelStorei(GL_UNPACK_ROW_LENGTH, (GLint)row_length);
+					glTexSubImage2D(GL_TEXTURE_2D, 0, offset.x, offset.y, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, data);
+					if(row_length != size.x) glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+				}
+				//The contents are undefined
+				void AllocateTextureStorage(HandleType txt_handle, pos2du16 size){
+					State::BindTexture(txt_handle);
+					glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+				}
+				//GL 4.4 or ARB_clear_texture, otherwise the texture is cleared through its framebuffer
+				bool IsClearTextureSupported() { return GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_clear_texture; }
+				void ClearTexture(HandleType txt_handle, HandleType fb_handle){
+					if(IsClearTextureSupported()){
+						glClearTexImage(txt_handle, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr); //Null means zeros
+						return;
+					}
+					State::BindFramebuffer(fb_handle);
+					State::SetCapability(Opt::SCISSOR_TEST, GL_SCISSOR_TEST, false);
+					State::shadow.applied_pipeline = nullptr; //Its scissor test has to be enabled again
+					glClearColor(0.f, 0.f, 0.f, 0.f);
+					glClear(GL_COLOR_BUFFER_BIT);
+				}
 				void GetTextureData(HandleType txt_handle, uint8* dest){
-					glBindTexture(GL_TEXTURE_2D, txt_handle);
+					State::BindTexture(txt_handle);
 					glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, dest);
 				}
 				void SetTextureFilteringMode(HandleType txt_handle, JGFX::TxtFiltMode mode){
 					const GLint modes[] = { GL_NEAREST, GL_LINEAR };
-					glBindTexture(GL_TEXTURE_2D, txt_handle);
+					State::BindTexture(txt_handle);
 					glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, modes[(int)mode]);
 					glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, modes[(int)mode]);
 				}
 				void SetTextureWrapMode(HandleType txt_handle, JGFX::TxtWrapMode mode){
 					const GLint modes[] = { GL_REPEAT, GL_MIRRORED_REPEAT, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_BORDER};
-					glBindTexture(GL_TEXTURE_2D, txt_handle);
+					State::BindTexture(txt_handle);
 					glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, modes[(int)mode]);
 					glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, modes[(int)mode]);
 				}
@@ -60,7 +89,7 @@ namespace LLJGFX {
 					return handle;
 				}
 				void DeleteFramebuffer(HandleType fb_handle)
-					{ glDeleteFramebuffers(1, &fb_handle); }
+					{ glDeleteFramebuffers(1, &fb_handle); State::ForgetFramebuffer(fb_handle); }
 				HandleType MakeRenderbuffer(){
 					HandleType handle;
 					glGenRenderbuffers(1, &handle);
@@ -72,15 +101,49 @@ namespace LLJGFX {
 					glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, new_size.x, new_size.y);
 				}
 				void BindRenderbufferToFramebuffer(HandleType fb_handle, HandleType rb_handle){
-					glBindFramebuffer(GL_FRAMEBUFFER, fb_handle);
+					State::BindFramebuffer(fb_handle);
 					glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
 					                          GL_RENDERBUFFER, rb_handle);
-					glBindFramebuffer(GL_FRAMEBUFFER, 0);
+					State::BindFramebuffer(0);
 				}
 				void BindTextureToFramebuffer(HandleType fb_handle, HandleType txt_attachment){
-					glBindFramebuffer(GL_FRAMEBUFFER, fb_handle);
+					State::BindFramebuffer(fb_handle);
 					glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, txt_attachment, 0);
-					glBindFramebuffer(GL_FRAMEBUFFER, 0);
+					State::BindFramebuffer(0);
+				}
+
+				bool IsGpuCopySupported() { return true; }
+				//Copies between textures without framebuffers, but only 1:1
+				bool IsImageCopySupported() { return GLAD_GL_VERSION_4_3 || GLAD_GL_ARB_copy_image; }
+				void CopyImage(HandleType src_txt, pos2du16 src_offset, HandleType dst_txt, pos2du16 dst_offset, pos2du16 size){
+					glCopyImageSubData(src_txt, GL_TEXTURE_2D, 0, src_offset.x, src_offset.y, 0,
+					                   dst_txt, GL_TEXTURE_2D, 0, dst_offset.x, dst_offset.y, 0,
+					                   size.x, size.y, 1);
+				}
+				//The textures are attached to the scratch framebuffers only for the blit, so no depth buffer is made for them.
+				//An invalid "dst_txt" means "dst_fb" is drawn to as it is(0 is the window).
+				//The read and draw bindings are split, so the shadow forgets the framebuffer and it has to be rebound
+				void BlitFramebuffer(HandleType src_fb, HandleType src_txt, pos2du16 src_offset, pos2du16 src_size,
+				                     HandleType dst_fb, HandleType dst_txt, pos2du16 dst_offset, pos2du16 dst_size, bool linear){
+					glBindFramebuffer(GL_READ_FRAMEBUFFER, src_fb);
+					glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, src_txt, 0);
+					glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dst_fb);
+					if(dst_txt != INVALID_HANDLE)
+						glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, dst_txt, 0);
+					State::shadow.framebuffer = State::UNKNOWN;
+
+					//The blit is clipped by the scissor test, the pipeline enables it again when it's applied
+					State::SetCapability(Opt::SCISSOR_TEST, GL_SCISSOR_TEST, false);
+					State::shadow.applied_pipeline = nullptr;
+
+					glBlitFramebuffer(src_offset.x, src_offset.y, src_offset.x + src_size.x, src_offset.y + src_size.y,
+					                  dst_offset.x, dst_offset.y, dst_offset.x + dst_size.x, dst_offset.y + dst_size.y,
+					                  GL_COLOR_BUFFER_BIT, linear ? GL_LINEAR : GL_NEAREST);
+
+					//A deleted texture would stay alive while it's attached
+					glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+					if(dst_txt != INVALID_HANDLE)
+						glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
 				}
 			}
 			namespace PreInit{
@@ -99,6 +162,20 @@ namespace LLJGFX {
 					txt_data.find(txt_handle)->second.data =
 							{(const char*)data, (size_t)(size.x * size.y * JGFX::PIXEL_BINARY_SIZE)};
 				}
+				void SetTextureSubData(HandleType txt_handle, pos2du16 txt_size, pos2du16 offset, pos2du16 size,
+				                       const uint8* data, uint32 row_length){
+					std::string& dest = txt_data.find(txt_handle)->second.data;
+					for(uint32 y = 0; y < size.y; y++)
+						memcpy(dest.data() + ((size_t)(offset.y + y) * txt_size.x + offset.x) * JGFX::PIXEL_BINARY_SIZE,
+						       data + (size_t)y * row_length * JGFX::PIXEL_BINARY_SIZE, (size_t)size.x * JGFX::PIXEL_BINARY_SIZE);
+				}
+				void AllocateTextureStorage(HandleType txt_handle, pos2du16 size)
+					{ txt_data.find(txt_handle)->second.data.assign((size_t)size.x * size.y * JGFX::PIXEL_BINARY_SIZE, (char)0); }
+				bool IsClearTextureSupported() { return true; }
+				void ClearTexture(HandleType txt_handle, HandleType fb_handle){
+					std::string& data = txt_data.find(txt_handle)->second.data;
+					std::fill(data.begin(), data.end(), (char)0);
+				}
 				void GetTextureData(HandleType txt_handle, uint8* dest){
 					const std::string& data = txt_data.find(txt_handle)->second.data;
 					memcpy(dest, data.data(), data.size());
@@ -117,12 +194,23 @@ namespace LLJGFX {
 				void ResizeRenderbuffer(HandleType rb_handle, pos2du16 new_size){}
 				void BindRenderbufferToFramebuffer(HandleType fb_handle, HandleType rb_handle){}
 				void BindTextureToFramebuffer(HandleType fb_handle, HandleType txt_attachment){}
+
+				//Copies go through the CPU copies of the textures before there is a context
+				bool IsGpuCopySupported() { return false; }
+				bool IsImageCopySupported() { return false; }
+				void CopyImage(HandleType src_txt, pos2du16 src_offset, HandleType dst_txt, pos2du16 dst_offset, pos2du16 size){}
+				void BlitFramebuffer(HandleType src_fb, HandleType src_txt, pos2du16 src_offset, pos2du16 src_size,
+				                     HandleType dst_fb, HandleType dst_txt, pos2du16 dst_offset, pos2du16 dst_size, bool linear){}
 			}
 
 			//Function pointers
 			HandleType (*MakeTexture)() = PreInit::MakeTexture;
 			void (*DeleteTexture)(HandleType) = PreInit::DeleteTexture;
 			void (*SetTextureData)(HandleType, const uint8*, pos2du16) = PreInit::SetTextureData;
+			void (*SetTextureSubData)(HandleType, pos2du16, pos2du16, pos2du16, const uint8*, uint32) = PreInit::SetTextureSubData;
+			void (*AllocateTextureStorage)(HandleType, pos2du16) = PreInit::AllocateTextureStorage;
+			bool (*IsClearTextureSupported)() = PreInit::IsClearTextureSupported;
+			void (*ClearTexture)(HandleType, HandleType) = PreInit::ClearTexture;
 			void (*GetTextureData)(HandleType, uint8*) = PreInit::GetTextureData;
 			void (*SetTextureFilteringMode)(HandleType, JGFX::TxtFiltMode) = PreInit::SetTextureFilteringMode;
 			void (*SetTextureWrapMode)(HandleType, JGFX::TxtWrapMode) = PreInit::SetTextureWrapMode;
@@ -136,13 +224,18 @@ namespace LLJGFX {
 			void (*BindRenderbufferToFramebuffer)(HandleType, HandleType) = PreInit::BindRenderbufferToFramebuffer;
 			void (*BindTextureToFramebuffer)(HandleType, HandleType) = PreInit::BindTextureToFramebuffer;
 
+			bool (*IsGpuCopySupported)() = PreInit::IsGpuCopySupported;
+			bool (*IsImageCopySupported)() = PreInit::IsImageCopySupported;
+			void (*CopyImage)(HandleType, pos2du16, HandleType, pos2du16, pos2du16) = PreInit::CopyImage;
+			void (*BlitFramebuffer)(HandleType, HandleType, pos2du16, pos2du16, HandleType, HandleType, pos2du16, pos2du16, bool) = PreInit::BlitFramebuffer;
+
 
 			void BindFramebuffer(int handle, pos2du16 size){
-				glBindFramebuffer(GL_FRAMEBUFFER, handle);
-				glViewport(0, 0, size.x, size.y);
+				State::BindFramebuffer(handle);
+				State::Viewport(size);
 			}
 			void SetViewportSize(pos2du16 size){
-				glViewport(0, 0, size.x, size.y);
+				State::Viewport(size);
 			}
 		}
 	}
@@ -0,0 +1,36 @@
+#pragma once
+#include <glad/glad.h>
+
+#include "../Common.h"
+#include "State.h"
+
+namespace LLJGFX{
+	namespace Internal{
+		namespace Gpu{
+			namespace Opengl33{
+				//The vertex array and the program must be bound already. Every vertex is captured as a point, the
+				//rasterizer is skipped when nothing has to be drawn
+				void CaptureVertices(const HandleType* buffers, uint32 buffer_count, uint32 first_vertex, uint32 vertex_count,
+				                     bool discard_rasterizer){
+					for(uint32 i = 0; i < buffer_count; i++)
+						glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, i, buffers[i]);
+					if(discard_rasterizer) glEnable(GL_RASTERIZER_DISCARD);
+
+					glBeginTransformFeedback(GL_POINTS);
+					glDrawArrays(GL_POINTS, (GLint)first_vertex, (GLsizei)vertex_count);
+					glEndTransformFeedback();
+
+					if(discard_rasterizer) glDisable(GL_RASTERIZER_DISCARD);
+					//A buffer can't be a vertex source while it's still a capture target
+					for(uint32 i = 0; i < buffer_count; i++)
+						glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, i, 0);
+				}
+			}
+			namespace PreInit{
+				void CaptureVertices(const HandleType* buffers, uint32 buffer_count, uint32 first_vertex, uint32 vertex_count,
+				                     bool discard_rasterizer) {}
+			}
+			void (*CaptureVertices)(const HandleType*, uint32, uint32, uint32, bool) = PreInit::CaptureVertices;
+		}
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <glad/glad.h>
+
+#include "../Common.h"
+#include "State.h"
+
+namespace LLJGFX{
+	namespace Internal{
+		namespace Gpu{
+			namespace Opengl33{
+				HandleType MakeUniformBuffer(size_t size){
+					HandleType handle;
+					glGenBuffers(1, &handle);
+					glBindBuffer(GL_UNIFORM_BUFFER, handle);
+					glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+					return handle;
+				}
+				void DeleteUniformBuffer(HandleType handle) { glDeleteBuffers(1, &handle); State::ForgetBuffer(handle); }
+
+				//Replacing the whole buffer orphans it, so the upload doesn't wait for the draws, that still read the old data
+				void SetUniformBufferData(HandleType handle, size_t buffer_size, size_t offset, const void* data, size_t size){
+					glBindBuffer(GL_UNIFORM_BUFFER, handle);
+					if(offset == 0 && size == buffer_size) glBufferData(GL_UNIFORM_BUFFER, size, data, GL_DYNAMIC_DRAW);
+					else glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+				}
+				void BindUniformBuffer(uint32 binding_point, HandleType handle)
+					{ State::BindUniformBufferBase(binding_point, handle); }
+			}
+			namespace PreInit{
+				HandleType MakeUniformBuffer(size_t size) { return INVALID_HANDLE; }
+				void DeleteUniformBuffer(HandleType handle) {}
+				void SetUniformBufferData(HandleType handle, size_t buffer_size, size_t offset, const void* data, size_t size) {}
+				void BindUniformBuffer(uint32 binding_point, HandleType handle) {}
+			}
+			HandleType (*MakeUniformBuffer)(size_t) = PreInit::MakeUniformBuffer;
+			void (*DeleteUniformBuffer)(HandleType) = PreInit::DeleteUniformBuffer;
+			void (*SetUniformBufferData)(HandleType, size_t, size_t, const void*, size_t) = PreInit::SetUniformBufferData;
+			void (*BindUniformBuffer)(uint32, HandleType) = PreInit::BindUniformBuffer;
+		}
+	}
+}
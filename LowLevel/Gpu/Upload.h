@@ -0,0 +1,140 @@
+#pragma once
+#include <cstring>
+#include <vector>
+#include <unordered_map>
+#include <glad/glad.h>
+
+#include "../Common.h"
+#include "State.h"
+#include "Texture.h"
+
+//Pixel buffers and fences(GL 3.2 is enough). Before the initialization the pixel buffers are plain memory and
+//the uploads go straight into the CPU copies of the textures
+namespace LLJGFX{
+	namespace Internal{
+		namespace Gpu{
+			namespace Opengl33{
+				HandleType MakePixelBuffer(size_t size){
+					HandleType handle;
+					glGenBuffers(1, &handle);
+					glBindBuffer(GL_PIXEL_UNPACK_BUFFER, handle);
+					glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+					glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+					return handle;
+				}
+				//Pack(readback) buffers are deleted with it too
+				void DeletePixelBuffer(HandleType buff)
+					{ glDeleteBuffers(1, &buff); State::ForgetBuffer(buff); }
+
+				//Not synchronized, the caller makes sure with fences, that the GPU isn't reading the range anymore
+				uint8* MapPixelBuffer(HandleType buff, size_t offset, size_t size){
+					glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buff);
+					uint8* ptr = (uint8*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, offset, size,
+					                                      GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+					glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+					return ptr;
+				}
+				//The texture reads the buffer at "buff_offset" once the GPU gets to it, the call itself doesn't wait.
+				//The buffer is unbound afterwards, otherwise every other upload would read from it
+				void UploadFromPixelBuffer(HandleType buff, size_t buff_offset, HandleType txt_handle, pos2du16 txt_size,
+				                           pos2du16 offset, pos2du16 size){
+					glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buff);
+					glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+					State::BindTexture(txt_handle);
+					glTexSubImage2D(GL_TEXTURE_2D, 0, offset.x, offset.y, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE,
+					                (const void*)buff_offset);
+					glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+				}
+
+				HandleType MakeReadbackBuffer(size_t size){
+					HandleType handle;
+					glGenBuffers(1, &handle);
+					glBindBuffer(GL_PIXEL_PACK_BUFFER, handle);
+					glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+					glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+					return handle;
+				}
+				//Only queues the copy, the pixels land in the buffer once the GPU gets to it. The framebuffer binding
+				//is changed
+				//A texture is attached to "fb_handle" for the read(see BlitFramebuffer()), INVALID_HANDLE reads the framebuffer as it is
+				void ReadPixelsToBuffer(HandleType fb_handle, HandleType txt_handle, pos2du16 offset, pos2du16 size, HandleType buff){
+					State::BindFramebuffer(fb_handle);
+					if(txt_handle != INVALID_HANDLE)
+						glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, txt_handle, 0);
+					glBindBuffer(GL_PIXEL_PACK_BUFFER, buff);
+					glReadPixels(offset.x, offset.y, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+					glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+					if(txt_handle != INVALID_HANDLE) //A deleted texture would stay alive while it's attached
+						glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+				}
+				//Waits for the copy if it isn't done yet, "row_length" is the same as in SetTextureSubData()
+				void ReadBufferPixels(HandleType buff, pos2du16 size, uint8* dest, uint32 row_length){
+					const size_t row_size = (size_t)size.x * JGFX::PIXEL_BINARY_SIZE;
+					glBindBuffer(GL_PIXEL_PACK_BUFFER, buff);
+					const uint8* src = (const uint8*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, row_size * size.y, GL_MAP_READ_BIT);
+					if(row_length == size.x)
+						memcpy(dest, src, row_size * size.y);
+					else for(uint32 y = 0; y < size.y; y++)
+						memcpy(dest + (size_t)y * row_length * JGFX::PIXEL_BINARY_SIZE, src + y * row_size, row_size);
+					glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+					glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+				}
+
+				GLsync InsertFence() { return glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0); }
+				//A fence, that is only polled, never signals, if the commands before it aren't submitted
+				void FlushCommands() { glFlush(); }
+				bool IsFenceSignaled(GLsync fence){
+					const GLenum result = glClientWaitSync(fence, 0, 0);
+					return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+				}
+				void WaitFence(GLsync fence){
+					while(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {}
+				}
+				void DeleteFence(GLsync fence) { glDeleteSync(fence); }
+			}
+			namespace PreInit{
+				std::unordered_map<HandleType, std::vector<uint8>> pixel_buffers;
+				HandleType pixel_buffer_last_handle = 1;
+
+				HandleType MakePixelBuffer(size_t size){
+					pixel_buffers[pixel_buffer_last_handle].resize(size);
+					return pixel_buffer_last_handle++;
+				}
+				void DeletePixelBuffer(HandleType buff) { pixel_buffers.erase(buff); }
+				uint8* MapPixelBuffer(HandleType buff, size_t offset, size_t size)
+					{ return pixel_buffers.find(buff)->second.data() + offset; }
+				void UploadFromPixelBuffer(HandleType buff, size_t buff_offset, HandleType txt_handle, pos2du16 txt_size,
+				                           pos2du16 offset, pos2du16 size){
+					SetTextureSubData(txt_handle, txt_size, offset, size, pixel_buffers.find(buff)->second.data() + buff_offset, size.x);
+				}
+
+				//Readbacks copy the pixels right away before the initialization(see Readback.h), these aren't reached
+				HandleType MakeReadbackBuffer(size_t size) { return INVALID_HANDLE; }
+				void ReadPixelsToBuffer(HandleType fb_handle, HandleType txt_handle, pos2du16 offset, pos2du16 size, HandleType buff){}
+				void ReadBufferPixels(HandleType buff, pos2du16 size, uint8* dest, uint32 row_length){}
+
+				//Everything is done right away, so there is nothing to wait for
+				GLsync InsertFence() { return nullptr; }
+				bool IsFenceSignaled(GLsync fence) { return true; }
+				void FlushCommands(){}
+				void WaitFence(GLsync fence){}
+				void DeleteFence(GLsync fence){}
+			}
+
+			HandleType (*MakePixelBuffer)(size_t) = PreInit::MakePixelBuffer;
+			void (*DeletePixelBuffer)(HandleType) = PreInit::DeletePixelBuffer;
+			uint8* (*MapPixelBuffer)(HandleType, size_t, size_t) = PreInit::MapPixelBuffer;
+			void (*UploadFromPixelBuffer)(HandleType, size_t, HandleType, pos2du16, pos2du16, pos2du16) = PreInit::UploadFromPixelBuffer;
+
+			HandleType (*MakeReadbackBuffer)(size_t) = PreInit::MakeReadbackBuffer;
+			void (*ReadPixelsToBuffer)(HandleType, HandleType, pos2du16, pos2du16, HandleType) = PreInit::ReadPixelsToBuffer;
+			void (*ReadBufferPixels)(HandleType, pos2du16, uint8*, uint32) = PreInit::ReadBufferPixels;
+
+			GLsync (*InsertFence)() = PreInit::InsertFence;
+			bool (*IsFenceSignaled)(GLsync) = PreInit::IsFenceSignaled;
+			void (*FlushCommands)() = PreInit::FlushCommands;
+			void (*WaitFence)(GLsync) = PreInit::WaitFence;
+			void (*DeleteFence)(GLsync) = PreInit::DeleteFence;
+		}
+	}
+}
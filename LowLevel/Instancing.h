@@ -0,0 +1,175 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <type_traits>
+
+#include "Draw.h"
+
+//Merges consecutive draws, that differ only in a per-object payload(model matrix, colour...), into one instanced draw.
+//The payloads are streamed into an instance buffer, that is attached to the drawn VRef with divisor 1.
+//The layout ids of the payload must not collide with the ones the mesh uses.
+//The pending batch is drawn by Flush(), and automatically before anything, that would change what it's drawn with:
+//other draws and clears, framebuffer binds, Opt toggles, program binds, uniform writes and texture changes.
+//Changing the data of the mesh itself(e.g. VBuff::SetSubData()) still needs an explicit Flush()
+namespace LLJGFX{
+	namespace Internal{
+		struct BatcherDataHolder{
+			JGFX::VertexLayout instance_layout;
+			size_t stride = 0;
+			std::unordered_map<VRef::Handle, VBuff::Handle> instance_buffers;
+
+			TmpRT curr_batch;
+			bool has_batch = false;
+			std::vector<uint8> payloads;
+			uint32 payload_count = 0;
+
+			uint64 submitted_draws = 0;
+			uint64 issued_draws = 0;
+		};
+
+		std::unordered_set<BatcherDataHolder*> all_batcher_handles;
+		std::vector<BatcherDataHolder*> pending_batchers; //The ones with a batch, in the order the batches were started
+
+		inline bool IsSameBatch(const TmpRT& a, const TmpRT& b){
+			if(a.vr_handle.handle != b.vr_handle.handle || a.sh_handle.data != b.sh_handle.data ||
+			   a.pipeline.data != b.pipeline.data) return false;
+			if(a.range.index_offset != b.range.index_offset || a.range.index_count != b.range.index_count ||
+			   a.range.base_vertex != b.range.base_vertex) return false;
+			if(a.texture_bindings.size() != b.texture_bindings.size()) return false;
+
+			for(size_t i = 0; i < a.texture_bindings.size(); i++)
+				if(a.texture_bindings[i].slot_id != b.texture_bindings[i].slot_id ||
+				   a.texture_bindings[i].texture_handle.data != b.texture_bindings[i].texture_handle.data) return false;
+			return true;
+		}
+
+		inline VBuff::Handle GetInstanceBuffer(BatcherDataHolder& dat, VRef::Handle vr_handle){
+			std::unordered_map<VRef::Handle, VBuff::Handle>::iterator iter = dat.instance_buffers.find(vr_handle);
+			if(iter == dat.instance_buffers.end()){
+				const VBuff::Handle vbuff = VBuff::Make();
+				VBuff::SetLayout(vbuff, dat.instance_layout);
+				iter = dat.instance_buffers.insert({vr_handle, vbuff}).first;
+			}
+			//The VRef could be deleted and its name reused since the last time
+			if(!find_vb_data(iter->second).bound_to.contains(vr_handle))
+				VRef::AttachVBuff(vr_handle, iter->second);
+			return iter->second;
+		}
+	}
+
+	namespace Batcher{
+		struct Handle{
+			Internal::BatcherDataHolder* data = nullptr;
+		};
+		inline void Flush(Handle batcher_handle);
+	}
+	namespace Internal{
+		void FlushAllBatches(){
+			while(!pending_batchers.empty())
+				Batcher::Flush({pending_batchers.front()});
+		}
+	}
+
+	namespace Batcher{
+		struct Stats{
+			uint64 submitted_draws = 0; //Draws given to the batcher
+			uint64 issued_draws = 0; //Instanced draws that actually reached GL
+		};
+
+		inline bool IsValid(Handle batcher_handle) { return Internal::all_batcher_handles.contains(batcher_handle.data); }
+
+		//Draws everything that was merged so far
+		inline void Flush(Handle batcher_handle){
+			Internal::BatcherDataHolder& dat = *batcher_handle.data;
+			if(!dat.has_batch) return;
+
+			//Taken out of the pending list first, the draw below flushes the other pending batches
+			dat.has_batch = false;
+			std::erase(Internal::pending_batchers, batcher_handle.data);
+			if(Internal::pending_batchers.empty()) Internal::FlushPendingBatches = Internal::NoPendingBatches;
+
+			const VBuff::Handle vbuff = Internal::GetInstanceBuffer(dat, dat.curr_batch.vr_handle);
+			VBuff::StreamData(vbuff, dat.payloads.data(), dat.payloads.size());
+
+			dat.curr_batch.instances = dat.payload_count;
+			LLJGFX::Draw(dat.curr_batch);
+
+			dat.issued_draws++;
+			dat.payloads.clear();
+			dat.payload_count = 0;
+		}
+
+		//"payload" must point to stride bytes matching the instance layout given to Make(). The draw itself must not be instanced
+		inline void DrawRaw(Handle batcher_handle, const TmpRT& target, const void* payload){
+#ifndef NDEBUG
+			if(!IsValid(batcher_handle))
+				throw std::runtime_error("Deleted or uninitialized instance batcher was requested");
+			if(target.instances != 1)
+				throw std::runtime_error("Instanced draws can't be merged by the instance batcher");
+#endif
+			Internal::BatcherDataHolder& dat = *batcher_handle.data;
+			if(dat.has_batch && !Internal::IsSameBatch(dat.curr_batch, target))
+				Flush(batcher_handle);
+
+			if(!dat.has_batch){
+				dat.curr_batch = target;
+				dat.has_batch = true;
+				Internal::pending_batchers.push_back(batcher_handle.data);
+				Internal::FlushPendingBatches = Internal::FlushAllBatches;
+			}
+			dat.payloads.insert(dat.payloads.end(), (const uint8*)payload, (const uint8*)payload + dat.stride);
+			dat.payload_count++;
+			dat.submitted_draws++;
+		}
+		template<typename T> inline void Draw(Handle batcher_handle, const TmpRT& target, const T& payload){
+			static_assert(!std::is_pointer_v<T>, "Pass the payload itself, or use DrawRaw() for untyped memory");
+#ifndef NDEBUG
+			if(sizeof(T) != batcher_handle.data->stride)
+				throw std::runtime_error("The payload given to the instance batcher does not match the instance layout");
+#endif
+			DrawRaw(batcher_handle, target, (const void*)&payload);
+		}
+
+		inline Stats GetStats(Handle batcher_handle)
+			{ return { batcher_handle.data->submitted_draws, batcher_handle.data->issued_draws }; }
+		inline void ResetStats(Handle batcher_handle)
+			{ batcher_handle.data->submitted_draws = batcher_handle.data->issued_draws = 0; }
+
+		inline Handle Make(const JGFX::VertexLayout& instance_layout){
+			Handle handle = { new Internal::BatcherDataHolder{} };
+			Internal::all_batcher_handles.insert(handle.data);
+			Internal::BatcherDataHolder& dat = *handle.data;
+
+			//Every attribute advances once per instance
+			for(JGFX::VertexAttribute i : JGFX::VertexLayout(instance_layout).Get()){
+				i.divisor = 1;
+				dat.instance_layout.Add(i);
+			}
+			dat.stride = dat.instance_layout.CalculateStride();
+			return handle;
+		}
+		inline void Delete(Handle batcher_handle){
+			if(batcher_handle.data == nullptr) return;
+#ifndef NDEBUG
+			if(!IsValid(batcher_handle))
+				throw std::runtime_error("Deleted instance batcher was requested");
+#endif
+			Internal::BatcherDataHolder& dat = *batcher_handle.data;
+			if(Internal::curr_context != nullptr){
+				Flush(batcher_handle); //A pending batch would be lost otherwise
+				for(const std::pair<const VRef::Handle, VBuff::Handle>& i : dat.instance_buffers)
+					VBuff::Delete(i.second); //Detaches it from the VRef too
+			}
+			else if(dat.has_batch){
+				//The window is gone(or it's the static teardown), there is nothing to draw into and no GL to call.
+				//The instance buffers were destroyed with the context
+				std::erase(Internal::pending_batchers, batcher_handle.data);
+				if(Internal::pending_batchers.empty()) Internal::FlushPendingBatches = Internal::NoPendingBatches;
+			}
+
+			Internal::all_batcher_handles.erase(batcher_handle.data);
+			delete batcher_handle.data;
+		}
+	}
+}
@@ -0,0 +1,175 @@
+#pragma once
+#include <unordered_set>
+
+#include "Shader.h"
+#include "Gpu/Draw.h"
+
+//Immutable bundles of a program and the raster state it's drawn with.
+//They are validated and translated to GL values once in Make(), a draw applies only the difference from the current state
+namespace LLJGFX{
+	struct BlendState{
+		bool enabled = false;
+		BlendFactor src_color = BlendFactor::SRC_ALPHA;
+		BlendFactor dst_color = BlendFactor::ONE_MINUS_SRC_ALPHA;
+		BlendFactor src_alpha = BlendFactor::SRC_ALPHA;
+		BlendFactor dst_alpha = BlendFactor::ONE_MINUS_SRC_ALPHA;
+		BlendOp op = BlendOp::ADD;
+	};
+	struct DepthState{
+		bool test = false;
+		bool write = true;
+		CompareFunc func = CompareFunc::LESS;
+		bool clamp = false;
+	};
+	struct ScissorState{
+		bool enabled = false;
+		pos2du16 offset = {0, 0}; //From the bottom left corner of the framebuffer
+		pos2du16 size = {0, 0};
+	};
+	struct StencilState{
+		bool enabled = false;
+		CompareFunc func = CompareFunc::ALWAYS;
+		int32 ref = 0;
+		uint32 read_mask = 0xFF;
+		uint32 write_mask = 0xFF;
+		StencilOp stencil_fail = StencilOp::KEEP;
+		StencilOp depth_fail = StencilOp::KEEP;
+		StencilOp pass = StencilOp::KEEP;
+	};
+
+	struct PipelineDesc{
+		ShaderProgram::Handle program = { nullptr }; //Null means the bound program
+		BlendState blend;
+		DepthState depth;
+		CullMode cull = CullMode::NONE;
+		ScissorState scissor;
+		StencilState stencil;
+	};
+
+	namespace Internal{
+		struct PipelineDataHolder{
+			PipelineDesc desc;
+			Gpu::RasterState raster;
+		};
+
+		std::unordered_set<PipelineDataHolder*> all_pipeline_handles;
+
+		void CheckPipelineValidity(PipelineDataHolder* data){
+			if(!all_pipeline_handles.contains(data))
+				throw std::runtime_error(data == nullptr ?
+				                         "Non-existent pipeline state was requested using uninitialized handle" :
+				                         "Deleted pipeline state was requested");
+		}
+
+		template<typename E, size_t N> inline GLenum TranslatePipelineEnum(E value, const GLenum (&table)[N], const char* what){
+			if((size_t)value >= N)
+				throw std::runtime_error(std::string("Invalid ") + what + " in the pipeline state");
+			return table[(size_t)value];
+		}
+
+		Gpu::RasterState ResolveRasterState(const PipelineDesc& desc){
+			if(desc.program.data != nullptr){
+				CheckProgramValidity(desc.program);
+				if(!desc.program.data->is_linked)
+					throw std::runtime_error("The program of a pipeline state must be linked");
+			}
+			if(desc.scissor.enabled && (desc.scissor.size.x == 0 || desc.scissor.size.y == 0))
+				throw std::runtime_error("The scissor box of a pipeline state is empty");
+
+			Gpu::RasterState st;
+			st.capabilities[Opt::BLEND] = desc.blend.enabled;
+			st.capabilities[Opt::CULL] = desc.cull != CullMode::NONE;
+			st.capabilities[Opt::DEPTH_CLAMP] = desc.depth.clamp;
+			st.capabilities[Opt::DEPTH_TEST] = desc.depth.test;
+			st.capabilities[Opt::SCISSOR_TEST] = desc.scissor.enabled;
+			st.capabilities[Opt::STENCIL_TEST] = desc.stencil.enabled;
+
+			st.blend_func[0] = TranslatePipelineEnum(desc.blend.src_color, Gpu::blend_factors, "blend factor");
+			st.blend_func[1] = TranslatePipelineEnum(desc.blend.dst_color, Gpu::blend_factors, "blend factor");
+			st.blend_func[2] = TranslatePipelineEnum(desc.blend.src_alpha, Gpu::blend_factors, "blend factor");
+			st.blend_func[3] = TranslatePipelineEnum(desc.blend.dst_alpha, Gpu::blend_factors, "blend factor");
+			st.blend_equation = TranslatePipelineEnum(desc.blend.op, Gpu::blend_ops, "blend operation");
+
+			st.depth_func = TranslatePipelineEnum(desc.depth.func, Gpu::compare_funcs, "depth function");
+			st.depth_write = desc.depth.write;
+			st.cull_face = TranslatePipelineEnum(desc.cull, Gpu::cull_faces, "cull mode");
+
+			st.scissor[0] = desc.scissor.offset.x;
+			st.scissor[1] = desc.scissor.offset.y;
+			st.scissor[2] = desc.scissor.size.x;
+			st.scissor[3] = desc.scissor.size.y;
+
+			st.stencil_func = TranslatePipelineEnum(desc.stencil.func, Gpu::compare_funcs, "stencil function");
+			st.stencil_ref = desc.stencil.ref;
+			st.stencil_read_mask = desc.stencil.read_mask;
+			st.stencil_op[0] = TranslatePipelineEnum(desc.stencil.stencil_fail, Gpu::stencil_ops, "stencil operation");
+			st.stencil_op[1] = TranslatePipelineEnum(desc.stencil.depth_fail, Gpu::stencil_ops, "stencil operation");
+			st.stencil_op[2] = TranslatePipelineEnum(desc.stencil.pass, Gpu::stencil_ops, "stencil operation");
+			st.stencil_write_mask = desc.stencil.write_mask;
+			return st;
+		}
+
+		//State of the draws, that don't reference a pipeline. It follows the Opt toggles
+		Gpu::RasterState legacy_raster_state = { .user_managed = true };
+
+		inline void UpdateLegacyRasterState(){
+			for(uint32 i = 0; i < Gpu::State::CAPABILITY_COUNT; i++)
+				legacy_raster_state.capabilities[i] = opt_modes[i];
+			Gpu::State::ForgetPipeline(&legacy_raster_state); //Other contexts forget it when they become current
+		}
+	}
+
+	namespace PipelineState{
+		struct Handle{
+			Internal::PipelineDataHolder* data = nullptr;
+		};
+
+		inline bool IsValid(Handle handle) { return Internal::all_pipeline_handles.contains(handle.data); }
+
+		inline Handle Make(const PipelineDesc& desc){
+			const Internal::Gpu::RasterState raster = Internal::ResolveRasterState(desc); //Throws before anything is allocated
+			Handle handle = { new Internal::PipelineDataHolder{desc, raster} };
+			Internal::all_pipeline_handles.insert(handle.data);
+			return handle;
+		}
+		inline void Delete(Handle pipeline_handle){
+			if(pipeline_handle.data == nullptr) return;
+#ifndef NDEBUG
+			Internal::CheckPipelineValidity(pipeline_handle.data);
+#endif
+			Internal::FlushPendingBatches();
+			Internal::Gpu::State::ForgetPipeline(pipeline_handle.data); //The address can be reused by the next one
+			Internal::all_pipeline_handles.erase(pipeline_handle.data);
+			delete pipeline_handle.data;
+		}
+
+		inline const PipelineDesc& GetDesc(Handle pipeline_handle){
+#ifndef NDEBUG
+			Internal::CheckPipelineValidity(pipeline_handle.data);
+#endif
+			return pipeline_handle.data->desc;
+		}
+		inline ShaderProgram::Handle GetProgram(Handle pipeline_handle) { return GetDesc(pipeline_handle).program; }
+	}
+
+	namespace Internal{
+		//A null pipeline means the Opt toggles
+		inline void ApplyPipeline(PipelineState::Handle pipeline_handle){
+			if(pipeline_handle.data == nullptr) Gpu::ApplyRasterState(legacy_raster_state, &legacy_raster_state);
+			else{
+#ifndef NDEBUG
+				CheckPipelineValidity(pipeline_handle.data);
+#endif
+				Gpu::ApplyRasterState(pipeline_handle.data->raster, pipeline_handle.data);
+			}
+		}
+
+		//Explicit program first, then the one of the pipeline, then the bound one
+		inline ShaderProgram::Handle GetDrawProgram(ShaderProgram::Handle sh_handle, PipelineState::Handle pipeline_handle){
+			if(sh_handle.data != nullptr) return sh_handle;
+			if(pipeline_handle.data != nullptr && pipeline_handle.data->desc.program.data != nullptr)
+				return pipeline_handle.data->desc.program;
+			return bound_shader;
+		}
+	}
+}
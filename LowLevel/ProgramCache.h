@@ -0,0 +1,124 @@
+#pragma once
+#include <string>
+#include <cstdio>
+#include <fstream>
+#include <filesystem>
+
+#include "Gpu/Shader.h"
+
+//Linked programs are stored as driver binaries, named by a hash of their sources and the driver string.
+//The file keeps the whole key too, so a hash collision is detected and treated as a miss.
+//Off until a directory is set. A binary, that the driver rejects, is deleted and the program is built from source
+namespace LLJGFX{
+	struct ProgramCacheStats{
+		uint64 hits = 0; //Programs loaded from a binary
+		uint64 misses = 0; //Programs built from source(and stored)
+		uint64 rejected = 0; //Binaries the driver refused to load
+	};
+
+	namespace Internal{
+		struct ProgramCacheData{
+			std::string directory;
+			bool is_supported = false; //Known only after the initialization
+			std::string driver;
+			ProgramCacheStats stats;
+		};
+		ProgramCacheData program_cache;
+
+		inline uint64 HashFnv1a(const std::string& str, uint64 hash = 14695981039346656037ull){
+			for(const char i : str){
+				hash ^= (uint8)i;
+				hash *= 1099511628211ull;
+			}
+			return hash;
+		}
+
+		void InitializeProgramCache(){
+			program_cache.is_supported = Gpu::IsProgramBinarySupported();
+			program_cache.driver = Gpu::GetDriverString();
+		}
+		inline bool IsProgramCacheActive() { return program_cache.is_supported && !program_cache.directory.empty(); }
+
+		//Everything, that the binary depends on
+		inline std::string GetProgramCacheKey(const std::string& vertex_source, const std::string& fragment_source)
+			{ return vertex_source + '\0' + fragment_source + '\0' + program_cache.driver; }
+		inline std::string GetProgramCachePath(const std::string& key){
+			const uint64 hash = HashFnv1a(key);
+
+			char name[24];
+			snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)hash);
+			return (std::filesystem::path(program_cache.directory) / name).string();
+		}
+
+		//File layout: uint32 binary format, uint64 key size, the key, then the binary itself
+		bool LoadCachedProgram(HandleType prg, const std::string& key){
+			const std::string path = GetProgramCachePath(key);
+			std::ifstream file(path, std::ios::binary);
+			if(!file.is_open()) return false;
+
+			uint32 format = 0;
+			uint64 key_size = 0;
+			file.read((char*)&format, sizeof(format));
+			file.read((char*)&key_size, sizeof(key_size));
+			//Another program with the same hash or an older layout, it's overwritten, when this one is stored
+			if(!file || key_size != key.size()) return false;
+			std::string stored_key(key.size(), '\0');
+			file.read(stored_key.data(), (std::streamsize)stored_key.size());
+			if(!file || stored_key != key) return false;
+			const std::string binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+			file.close();
+
+			if(!binary.empty() && Gpu::LoadProgramBinary(prg, format, binary)){
+				program_cache.stats.hits++;
+				return true;
+			}
+			program_cache.stats.rejected++;
+			std::error_code ec;
+			std::filesystem::remove(path, ec);
+			return false;
+		}
+		void StoreCachedProgram(HandleType prg, const std::string& key){
+			program_cache.stats.misses++;
+			const std::string path = GetProgramCachePath(key);
+
+			uint32 format = 0;
+			std::string binary;
+			if(!Gpu::GetProgramBinary(prg, format, binary)) return;
+
+			//Written under another name first, so a crash can't leave a truncated binary behind
+			const std::string tmp_path = path + ".tmp";
+			{
+				std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+				if(!file.is_open()) return;
+				const uint64 key_size = key.size();
+				file.write((const char*)&format, sizeof(format));
+				file.write((const char*)&key_size, sizeof(key_size));
+				file.write(key.data(), (std::streamsize)key.size());
+				file.write(binary.data(), (std::streamsize)binary.size());
+			}
+			std::error_code ec;
+			std::filesystem::rename(tmp_path, path, ec);
+		}
+	}
+
+	namespace ProgramCache{
+		//Can be called before the window is created. An empty string turns the cache off
+		inline void SetDirectory(const std::string& directory){
+			Internal::program_cache.directory = directory;
+			if(!directory.empty()) std::filesystem::create_directories(directory);
+		}
+		inline const std::string& GetDirectory() { return Internal::program_cache.directory; }
+
+		//False before the initialization and on drivers without program binaries
+		inline bool IsActive() { return Internal::IsProgramCacheActive(); }
+
+		inline ProgramCacheStats GetStats() { return Internal::program_cache.stats; }
+
+		inline void Clear(){
+			if(Internal::program_cache.directory.empty()) return;
+			std::error_code ec;
+			for(const std::filesystem::directory_entry& i : std::filesystem::directory_iterator(Internal::program_cache.directory, ec))
+				if(i.path().extension() == ".bin") std::filesystem::remove(i.path(), ec);
+		}
+	}
+}
@@ -0,0 +1,151 @@
+#pragma once
+#include <vector>
+#include <unordered_set>
+
+#include "Texture.h"
+#include "Gpu/Upload.h"
+
+//Reading pixels back without stalling: Start() queues a copy into a pixel pack buffer and returns a ticket, the
+//pixels are read once the fence of the ticket has signaled. Any number of tickets can be in flight
+namespace LLJGFX{
+	namespace Internal{
+		struct ReadbackBuffer{
+			HandleType gpu_handle = INVALID_HANDLE;
+			size_t capacity = 0;
+		};
+
+		struct ReadbackDataHolder{
+			ReadbackBuffer buffer;
+			GLsync fence = nullptr;
+			pos2du16 size = { 0, 0 };
+			std::string cpu_pixels; //Before the initialization the pixels are copied right away
+		};
+
+		std::unordered_set<ReadbackDataHolder*> all_readback_handles;
+		//Released tickets and their buffers are kept for the next Start(), so steady readbacks don't make
+		//new GL buffers. Anything past the limit is freed
+		constexpr size_t READBACK_POOL_SIZE = 8;
+		std::vector<ReadbackDataHolder*> free_readback_holders;
+		std::vector<ReadbackBuffer> free_readback_buffers;
+
+		void CheckReadbackValidity(ReadbackDataHolder* data){
+			if(!all_readback_handles.contains(data))
+				throw std::runtime_error(data == nullptr ?
+				                         "Non-existent readback was requested using uninitialized handle" :
+				                         "Released readback was requested");
+		}
+
+		inline ReadbackBuffer AcquireReadbackBuffer(size_t size){
+			for(size_t i = 0; i < free_readback_buffers.size(); i++)
+				if(free_readback_buffers[i].capacity >= size){
+					const ReadbackBuffer res = free_readback_buffers[i];
+					free_readback_buffers.erase(free_readback_buffers.begin() + i);
+					return res;
+				}
+			return { Gpu::MakeReadbackBuffer(size), size };
+		}
+		inline ReadbackDataHolder* AcquireReadbackHolder(){
+			if(free_readback_holders.empty()) return new ReadbackDataHolder;
+			ReadbackDataHolder* res = free_readback_holders.back();
+			free_readback_holders.pop_back();
+			return res;
+		}
+	}
+
+	namespace Readback{
+		struct Handle{
+			Internal::ReadbackDataHolder* data = nullptr;
+		};
+
+		inline bool IsValid(Handle handle) { return Internal::all_readback_handles.contains(handle.data); }
+
+		//Queues reading "region" of a texture, or of the window of the current context if "txt_handle" is null
+		inline Handle Start(Texture::Handle txt_handle, TextureRegion region = {}){
+#ifndef NDEBUG
+			if(txt_handle.data != nullptr) Internal::CheckTextureValidity(txt_handle);
+			else if(Internal::curr_context == nullptr) throw std::runtime_error("There is no window to read back");
+#endif
+			region = Internal::ResolveRegion(region, txt_handle.data == nullptr ? Internal::GetCurrentWindowSize() : txt_handle.data->size);
+			Handle handle = { Internal::AcquireReadbackHolder() };
+			Internal::all_readback_handles.insert(handle.data);
+			Internal::ReadbackDataHolder& dat = *handle.data;
+			dat.size = region.size;
+			dat.fence = nullptr;
+			dat.cpu_pixels.clear();
+
+			if(!Internal::Gpu::IsGpuCopySupported()){
+				const std::string pixels = Texture::GetData(txt_handle);
+				const size_t row_size = (size_t)region.size.x * JGFX::PIXEL_BINARY_SIZE;
+				dat.cpu_pixels.resize(row_size * region.size.y);
+				for(uint32 y = 0; y < region.size.y; y++)
+					memcpy(dat.cpu_pixels.data() + y * row_size,
+					       pixels.data() + ((size_t)(region.offset.y + y) * txt_handle.data->size.x + region.offset.x) * JGFX::PIXEL_BINARY_SIZE,
+					       row_size);
+				return handle;
+			}
+
+			Internal::FlushPendingBatches(); //They could draw into what is read
+			dat.buffer = Internal::AcquireReadbackBuffer((size_t)region.size.x * region.size.y * JGFX::PIXEL_BINARY_SIZE);
+			//A texture is attached to the scratch framebuffer of the blits, so it doesn't get a render target of its own
+			if(txt_handle.data == nullptr)
+				Internal::Gpu::ReadPixelsToBuffer(0, INVALID_HANDLE, region.offset, region.size, dat.buffer.gpu_handle);
+			else Internal::Gpu::ReadPixelsToBuffer(Internal::GetBlitFramebuffers().read, txt_handle.data->texture_gpu_handle,
+			                                       region.offset, region.size, dat.buffer.gpu_handle);
+			dat.fence = Internal::Gpu::InsertFence();
+			Internal::Gpu::FlushCommands(); //IsReady() only polls
+			Internal::RebindBoundFramebuffer();
+			return handle;
+		}
+
+		inline bool IsReady(Handle rb_handle){
+#ifndef NDEBUG
+			Internal::CheckReadbackValidity(rb_handle.data);
+#endif
+			return rb_handle.data->fence == nullptr || Internal::Gpu::IsFenceSignaled(rb_handle.data->fence);
+		}
+		inline void Wait(Handle rb_handle){
+#ifndef NDEBUG
+			Internal::CheckReadbackValidity(rb_handle.data);
+#endif
+			if(rb_handle.data->fence != nullptr) Internal::Gpu::WaitFence(rb_handle.data->fence);
+		}
+
+		//Copies the pixels(4 bytes each, bottom row first) into "dest", waits if they aren't ready yet.
+		//"row_stride" is the width of "dest" in pixels, 0 means the rows are packed
+		inline void Read(Handle rb_handle, uint8* dest, uint32 row_stride = 0){
+			Wait(rb_handle);
+			const Internal::ReadbackDataHolder& dat = *rb_handle.data;
+			const uint32 row_length = row_stride == 0 ? dat.size.x : row_stride;
+			if(dat.fence != nullptr){
+				Internal::Gpu::ReadBufferPixels(dat.buffer.gpu_handle, dat.size, dest, row_length);
+				return;
+			}
+			const size_t row_size = (size_t)dat.size.x * JGFX::PIXEL_BINARY_SIZE;
+			for(uint32 y = 0; y < dat.size.y; y++)
+				memcpy(dest + (size_t)y * row_length * JGFX::PIXEL_BINARY_SIZE, dat.cpu_pixels.data() + y * row_size, row_size);
+		}
+
+		inline pos2du16 GetSize(Handle rb_handle) { return rb_handle.data->size; }
+		inline size_t GetBinarySize(Handle rb_handle)
+			{ return (size_t)rb_handle.data->size.x * rb_handle.data->size.y * JGFX::PIXEL_BINARY_SIZE; }
+
+		//The ticket and its buffer go back to the pool, it can be released before it's ready
+		inline void Release(Handle rb_handle){
+			if(rb_handle.data == nullptr) return;
+#ifndef NDEBUG
+			Internal::CheckReadbackValidity(rb_handle.data);
+#endif
+			Internal::ReadbackDataHolder& dat = *rb_handle.data;
+			if(dat.fence != nullptr){
+				Internal::Gpu::DeleteFence(dat.fence);
+				if(Internal::free_readback_buffers.size() < Internal::READBACK_POOL_SIZE)
+					Internal::free_readback_buffers.push_back(dat.buffer);
+				else Internal::Gpu::DeletePixelBuffer(dat.buffer.gpu_handle);
+			}
+			Internal::all_readback_handles.erase(rb_handle.data);
+			if(Internal::free_readback_holders.size() < Internal::READBACK_POOL_SIZE)
+				Internal::free_readback_holders.push_back(rb_handle.data);
+			else delete rb_handle.data;
+		}
+	}
+}
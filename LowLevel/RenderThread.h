@@ -0,0 +1,221 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <deque>
+#include <vector>
+#include <utility>
+
+#include "CommandBuffer.h"
+#include "Window.h"
+
+//Optional mode, where a JGFX-owned thread owns the GL context and does the submission and the swaps.
+//While it runs, the application thread may call only:
+//	- CommandBuffer::Make, Delete, IsValid, Record*, Reset, Append and GetSize
+//	- RenderThread::EnqueueCommands, EnqueueResourceUpdate, SetQueueDepth, GetQueueDepth, IsRunning and Stop
+//	- NewFrame, FrameArena::*, GetStateCacheStats, GetDeltaTimeValue and GetFpsValue
+//	- Window queries and setters(size, position, title, attributes), but not Window::Make and Delete
+//Everything else(making, deleting or changing textures, meshes, programs, uniforms and so on) must be passed
+//as a resource update: the render thread reads the handle sets and the objects, while it replays a frame.
+//GLFW can query the windows only on the application thread, so their sizes are sampled there by NewFrame.
+namespace LLJGFX{
+	namespace Internal{
+		struct FramePacket{
+			std::vector<std::function<void()>> resource_updates; //Executed before the commands
+			std::vector<CmdBuffDataHolder> command_streams;
+			size_t stream_count = 0; //The holders are kept between frames to reuse their memory
+			std::vector<std::pair<GLFWwindow*, pos2du16>> window_sizes; //Sampled, when the frame was pushed
+		};
+
+		struct RenderThreadData{
+			std::thread thread;
+			std::mutex mutex;
+			std::condition_variable packet_ready;
+			std::condition_variable packet_done;
+
+			std::deque<FramePacket> queue;
+			std::vector<FramePacket> free_packets;
+			FramePacket recording; //Filled by the application thread
+
+			size_t queue_depth = 2;
+			size_t executing = 0; //Popped from the queue, but not presented yet
+			bool is_running = false;
+			bool stop_requested = false;
+			std::exception_ptr error = nullptr;
+
+			//The current target is per thread, it's handed over on Start and Stop
+			WindowDataHolder* context = nullptr;
+			Texture::Handle framebuffer_texture = { nullptr };
+		};
+		RenderThreadData render_thread;
+
+		void ExecutePacket(FramePacket& packet){
+			replayed_window_sizes = &packet.window_sizes;
+			try{
+				for(std::function<void()>& i : packet.resource_updates)
+					i();
+				for(size_t i = 0; i < packet.stream_count; i++)
+					ReplayCommands(packet.command_streams[i]);
+
+				PresentNow();
+			}
+			catch(...){
+				replayed_window_sizes = nullptr;
+				throw;
+			}
+			replayed_window_sizes = nullptr;
+		}
+		void RecyclePacket(FramePacket& packet){
+			packet.resource_updates.clear();
+			for(size_t i = 0; i < packet.stream_count; i++)
+				CommandBuffer::Reset({&packet.command_streams[i]});
+			packet.stream_count = 0;
+			packet.window_sizes.clear();
+		}
+
+		void RenderThreadLoop(){
+			RenderThreadData& rt = render_thread;
+			curr_context = rt.context;
+			bound_framebuffer_texture = rt.framebuffer_texture;
+			Gpu::State::MakeContextCurrent(curr_context->win);
+
+			while(true){
+				FramePacket packet;
+				{
+					std::unique_lock<std::mutex> lock(rt.mutex);
+					rt.packet_ready.wait(lock, [&rt]{ return !rt.queue.empty() || rt.stop_requested; });
+					if(rt.queue.empty()) break; //Stop was requested and everything is drained
+
+					packet = std::move(rt.queue.front());
+					rt.queue.pop_front();
+					rt.executing++;
+				}
+
+				try{ ExecutePacket(packet); }
+				catch(...){
+					std::lock_guard<std::mutex> lock(rt.mutex);
+					if(rt.error == nullptr) rt.error = std::current_exception();
+				}
+				RecyclePacket(packet);
+
+				{
+					std::lock_guard<std::mutex> lock(rt.mutex);
+					rt.free_packets.push_back(std::move(packet));
+					rt.executing--;
+				}
+				rt.packet_done.notify_all();
+			}
+
+			rt.context = curr_context;
+			rt.framebuffer_texture = bound_framebuffer_texture;
+			Gpu::State::MakeContextCurrent(nullptr);
+		}
+
+		//Replaces PresentNow() while the render thread is running
+		void PushFramePacket(){
+			RenderThreadData& rt = render_thread;
+			for(WindowDataHolder* i : all_window_handles)
+				rt.recording.window_sizes.push_back({i->win, GetWindowSize(i->win)});
+
+			std::unique_lock<std::mutex> lock(rt.mutex);
+
+			//Back-pressure: the application can't get more than queue_depth frames ahead of the GPU submission,
+			//the frame that is being executed counts too
+			rt.packet_done.wait(lock, [&rt]{ return rt.queue.size() + rt.executing < rt.queue_depth || rt.error != nullptr; });
+			if(rt.error != nullptr){
+				std::exception_ptr error = rt.error;
+				rt.error = nullptr;
+				rt.recording.window_sizes.clear();
+				std::rethrow_exception(error);
+			}
+
+			rt.queue.push_back(std::move(rt.recording));
+			rt.recording = {};
+			if(!rt.free_packets.empty()){
+				rt.recording = std::move(rt.free_packets.back());
+				rt.free_packets.pop_back();
+			}
+			lock.unlock();
+			rt.packet_ready.notify_one();
+		}
+	}
+
+	namespace RenderThread{
+		inline bool IsRunning() { return Internal::render_thread.is_running; }
+
+		//queue_depth = 2 means double buffering, 3 - triple buffering and so on
+		inline void Start(size_t queue_depth = 2){
+			Internal::RenderThreadData& rt = Internal::render_thread;
+			if(rt.is_running)
+				throw std::runtime_error("The render thread is already running");
+			if(Internal::curr_context == nullptr)
+				throw std::runtime_error("The render thread needs a window to be created first");
+			if(queue_depth == 0)
+				throw std::runtime_error("The frame queue depth must be at least 1");
+
+			rt.queue_depth = queue_depth;
+			rt.executing = 0;
+			rt.stop_requested = false;
+			rt.is_running = true;
+			rt.context = Internal::curr_context;
+			rt.framebuffer_texture = Internal::bound_framebuffer_texture;
+
+			Internal::Gpu::State::MakeContextCurrent(nullptr); //The context can be current only on one thread
+			Internal::Present = Internal::PushFramePacket;
+			rt.thread = std::thread(Internal::RenderThreadLoop);
+		}
+		//Waits until every queued frame is submitted and gives the context back to the calling thread
+		inline void Stop(){
+			Internal::RenderThreadData& rt = Internal::render_thread;
+			if(!rt.is_running) return;
+
+			{
+				std::lock_guard<std::mutex> lock(rt.mutex);
+				rt.stop_requested = true;
+			}
+			rt.packet_ready.notify_one();
+			rt.thread.join();
+
+			rt.is_running = false;
+			Internal::Present = Internal::PresentNow;
+			Internal::curr_context = rt.context;
+			Internal::bound_framebuffer_texture = rt.framebuffer_texture;
+			Internal::Gpu::State::MakeContextCurrent(Internal::curr_context->win);
+
+			if(rt.error != nullptr){
+				std::exception_ptr error = rt.error;
+				rt.error = nullptr;
+				std::rethrow_exception(error);
+			}
+		}
+
+		inline void SetQueueDepth(size_t queue_depth){
+			if(queue_depth == 0)
+				throw std::runtime_error("The frame queue depth must be at least 1");
+			std::lock_guard<std::mutex> lock(Internal::render_thread.mutex);
+			Internal::render_thread.queue_depth = queue_depth;
+		}
+		inline size_t GetQueueDepth(){
+			std::lock_guard<std::mutex> lock(Internal::render_thread.mutex);
+			return Internal::render_thread.queue_depth;
+		}
+
+		//Adds GL work to the frame that is currently being recorded, it's executed before the frame's commands
+		inline void EnqueueResourceUpdate(std::function<void()> update)
+			{ Internal::render_thread.recording.resource_updates.push_back(std::move(update)); }
+
+		//Moves the recorded commands into the current frame, the buffer is left empty and can be recorded again
+		inline void EnqueueCommands(CommandBuffer::Handle cmd_handle){
+#ifndef NDEBUG
+			Internal::CheckCmdBuffValidity(cmd_handle.data);
+#endif
+			Internal::FramePacket& packet = Internal::render_thread.recording;
+			if(packet.stream_count == packet.command_streams.size())
+				packet.command_streams.emplace_back();
+
+			std::swap(packet.command_streams[packet.stream_count++], *cmd_handle.data);
+		}
+	}
+}
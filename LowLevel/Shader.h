@@ -1,30 +1,107 @@
 #pragma once
 #include <vector>
+#include <algorithm>
 #include <string>
+#include <string_view>
 #include <unordered_set>
 #include <unordered_map>
+#include <cstring>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <iostream>
 
 #include "Gpu/Shader.h"
+#include "ProgramCache.h"
 
 namespace LLJGFX{
 	namespace Internal {
-		struct ProgramDataHolder {
+		//Lets the uniform tables be searched with a string_view, so looking a name up doesn't allocate
+		struct UniformNameHash {
+			using is_transparent = void;
+			size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+		};
+		template<typename T> using UniformNameMap = std::unordered_map<std::string, T, UniformNameHash, std::equal_to<>>;
+
+		struct UniformSlot {
+			std::string name;
+			Gpu::UniformType type;
+			int32 location = -1;
+
+			uint32 data_offset = 0; //Inside of ProgramDataHolder::uniform_shadow
+			uint32 data_capacity = 0; //Bytes reserved at data_offset, reused while the written data fits
+			uint32 element_count = 0; //0 means the uniform wasn't written yet
+			bool is_dirty = false;
+		};
+
+		//One element of an active uniform, as GL holds it
+		struct GpuUniformValue {
+			Gpu::UniformType type;
+			uint32 data_offset = 0; //Inside of GpuProgram::default_uniform_values and gpu_uniform_values
+			int32 next_location = -1; //Of the next array element
+		};
+
+		struct ProgramDataHolder;
+
+		//The GL side of a program. Programs with identical sources share one, it's deleted with the last of them
+		struct GpuProgram {
 			HandleType gpu_handle = INVALID_HANDLE;
 
-			std::string bound_vs_src;
-			HandleType bound_vs_gpu_handle = INVALID_HANDLE;
+			std::string vs_src;
+			HandleType vs_gpu_handle = INVALID_HANDLE;
+
+			std::string fs_src;
+			HandleType fs_gpu_handle = INVALID_HANDLE;
+
+			//Captured by transform feedback, they are part of the link(and of the identity of the program)
+			std::vector<std::string> feedback_varyings;
+			bool feedback_interleaved = true;
+
+			//A compute program has only this stage
+			bool is_compute = false;
+			std::string cs_src;
+			HandleType cs_gpu_handle = INVALID_HANDLE;
 
-			std::string bound_fs_src;
-			HandleType bound_fs_gpu_handle = INVALID_HANDLE;
+			uint64 key = 0; //Hash of the sources
+			bool is_registered = false; //False only when the hash collided with other sources
+			std::vector<ProgramDataHolder*> users;
+
+			//Async builds(see ShaderProgram::CompileAsync()) are finished on the first use that needs the link
+			bool is_async = false;
+			bool is_pending = false;
+			std::string pending_cache_key; //The binary is stored once the link is done
+
+			//Built once per link, so setting a uniform doesn't query GL
+			ProgramReflection reflection;
+			UniformNameMap<int32> uniform_locations; //-1 for the names, that were asked, but don't exist
+			ProgramDataHolder* uniform_owner = nullptr; //The user, whose values were committed last
+
+			//Keyed by location. The defaults are read right after the link(GLSL initializers, sampler units),
+			//the other copy follows every upload, so values GL already has aren't sent again
+			std::unordered_map<int32, GpuUniformValue> gpu_uniform_layout;
+			std::vector<uint8> default_uniform_values;
+			std::vector<uint8> gpu_uniform_values;
+		};
+
+		struct ProgramDataHolder {
+			GpuProgram* gpu = nullptr; //Null until compiled
 
 			bool is_linked = false;
+			ProgramDataHolder* fallback = nullptr; //Drawn with, while this one is pending
+
+			std::vector<UniformSlot> uniform_slots; //Referenced by UniformHandle, they survive relinking
+			UniformNameMap<uint32> uniform_slot_ids;
+
+			//CPU copy of every written uniform. Only the dirty ones are sent to GL, when the program is used for a draw.
+			//It's per program, not per GpuProgram, so the sharing programs keep their own values
+			std::vector<uint8> uniform_shadow;
+			size_t uniform_shadow_waste = 0; //Bytes of the regions, that the slots moved out of
+			std::vector<uint32> dirty_uniform_slots;
 		};
 		const ProgramDataHolder default_program = {};
 
 		std::unordered_set<ProgramDataHolder *> all_program_handles;
+		std::unordered_set<GpuProgram *> all_gpu_programs;
+		std::unordered_map<uint64, GpuProgram*> gpu_program_registry;
 	}
 
 	namespace ShaderProgram {
@@ -34,6 +111,12 @@ namespace LLJGFX{
 
 		inline bool IsValid(Handle handle) { return Internal::all_program_handles.contains(handle.data); }
 	}
+
+	//Location of a uniform with its type fixed at compile time, see ShaderProgram::GetUniform()
+	template<typename T> struct UniformHandle {
+		Internal::ProgramDataHolder* program = nullptr;
+		uint32 slot = 0;
+	};
 	namespace Internal {
 		ShaderProgram::Handle bound_shader = { nullptr };
 
@@ -51,13 +134,392 @@ namespace LLJGFX{
 #endif
 			return *handle.data;
 		}
-//		inline size_t program_hash(ShaderProgram::Handle handle){
-//			const ProgramDataHolder& dat = get_ro_pr_data(handle);
-//			return std::hash<std::string>{}(dat.bound_vs_src + dat.bound_fs_src);
-//		}
+		inline HandleType GetGpuHandle(const ProgramDataHolder& dat) { return dat.gpu != nullptr ? dat.gpu->gpu_handle : 0; }
+
+		inline int32 ResolveUniformLocation(ProgramDataHolder& dat, std::string_view name){
+			if(dat.gpu == nullptr || dat.gpu->is_pending) return -1; //Resolved by RebuildUniformTable() when the link is done
+			GpuProgram& gp = *dat.gpu;
+
+			UniformNameMap<int32>::iterator iter = gp.uniform_locations.find(name);
+			if(iter != gp.uniform_locations.end()) return iter->second;
+
+			//Not in the active uniform list(e.g. an element of an array), asked once and cached.
+			//-1(optimized out or misspelled) is cached too, so it isn't asked again on every draw
+			const std::string name_str(name);
+			const int32 location = Gpu::GetUniformLocation(gp.gpu_handle, name_str);
+			gp.uniform_locations.insert({name_str, location});
+			return location;
+		}
+		//Block name -> binding point of every uniform buffer, programs are wired to them when they link
+		std::unordered_map<std::string, uint32> uniform_block_bindings;
+
+		//A new GpuProgram has none of the values on the GPU, so everything, that was written, is sent again
+		void RebuildUniformTable(ProgramDataHolder& dat){
+			dat.dirty_uniform_slots.clear();
+			for(uint32 i = 0; i < dat.uniform_slots.size(); i++){
+				UniformSlot& slot = dat.uniform_slots[i];
+				slot.location = ResolveUniformLocation(dat, slot.name);
+				slot.is_dirty = slot.element_count != 0;
+				if(slot.is_dirty) dat.dirty_uniform_slots.push_back(i);
+			}
+		}
+		//Reads the value of every element of every active uniform, that's what a user, who didn't set it, sees
+		void ReadUniformDefaults(GpuProgram& gp){
+			gp.gpu_uniform_layout.clear();
+			gp.default_uniform_values.clear();
+			for(const ShaderVariable& i : gp.reflection.uniforms){
+				const Gpu::UniformType type = i.type != Gpu::UniformType::INVALID ? i.type :
+				                              Gpu::IsSamplerType(i.gl_type) ? Gpu::UniformType::INT32 : Gpu::UniformType::INVALID;
+				if(type == Gpu::UniformType::INVALID) continue;
+				const size_t element_size = Gpu::type_size_table[(int32)type];
+				const std::string base_name = i.name.ends_with("[0]") ? i.name.substr(0, i.name.size() - 3) : i.name;
+
+				GpuUniformValue* prev = nullptr;
+				for(int32 j = 0; j < i.array_size; j++){
+					const int32 location = j == 0 ? i.location : Gpu::GetUniformLocation(gp.gpu_handle, base_name + '[' + std::to_string(j) + ']');
+					if(location == -1) break;
+
+					GpuUniformValue& value = gp.gpu_uniform_layout[location];
+					value = {type, (uint32)gp.default_uniform_values.size()};
+					gp.default_uniform_values.resize(gp.default_uniform_values.size() + element_size);
+					Gpu::GetUniformValue(gp.gpu_handle, location, type, gp.default_uniform_values.data() + value.data_offset);
+
+					if(prev != nullptr) prev->next_location = location;
+					prev = &value;
+				}
+			}
+			gp.gpu_uniform_values = gp.default_uniform_values;
+		}
+		//Sends the uniform, unless GL already has exactly this value
+		void SendUniform(GpuProgram& gp, int32 location, const std::string& name, Gpu::UniformType type,
+		                 const uint8* data, size_t element_count){
+			const size_t element_size = Gpu::type_size_table[(int32)type];
+			bool is_same = true;
+			int32 curr_location = location;
+			for(size_t i = 0; i < element_count && is_same; i++){
+				std::unordered_map<int32, GpuUniformValue>::const_iterator iter = gp.gpu_uniform_layout.find(curr_location);
+				is_same = iter != gp.gpu_uniform_layout.end() && iter->second.type == type &&
+				          memcmp(gp.gpu_uniform_values.data() + iter->second.data_offset, data + i * element_size, element_size) == 0;
+				if(is_same) curr_location = iter->second.next_location;
+			}
+			if(is_same) return;
+
+			Gpu::SetUniformAt(gp.gpu_handle, location, name, type, data, element_count);
+			curr_location = location;
+			for(size_t i = 0; i < element_count; i++){
+				std::unordered_map<int32, GpuUniformValue>::const_iterator iter = gp.gpu_uniform_layout.find(curr_location);
+				if(iter == gp.gpu_uniform_layout.end() || iter->second.type != type) break;
+				memcpy(gp.gpu_uniform_values.data() + iter->second.data_offset, data + i * element_size, element_size);
+				curr_location = iter->second.next_location;
+			}
+		}
+		//Puts back the post-link value of every element, that differs from it
+		void RestoreUniformDefault(GpuProgram& gp, int32 location, const std::string& name, size_t element_count){
+			int32 curr_location = location;
+			for(size_t i = 0; i < element_count; i++){
+				std::unordered_map<int32, GpuUniformValue>::const_iterator iter = gp.gpu_uniform_layout.find(curr_location);
+				if(iter == gp.gpu_uniform_layout.end()) return;
+				SendUniform(gp, curr_location, name, iter->second.type, gp.default_uniform_values.data() + iter->second.data_offset, 1);
+				curr_location = iter->second.next_location;
+			}
+		}
+
+		//Linking resets the values(and the block bindings) of every user
+		void OnProgramLinked(GpuProgram& gp){
+			Gpu::QueryProgramReflection(gp.gpu_handle, gp.reflection);
+			gp.uniform_locations.clear();
+			for(const ShaderVariable& i : gp.reflection.uniforms){
+				gp.uniform_locations[i.name] = i.location;
+				if(i.name.ends_with("[0]")) gp.uniform_locations[i.name.substr(0, i.name.size() - 3)] = i.location;
+			}
+			ReadUniformDefaults(gp);
+			for(const std::pair<const std::string, uint32>& i : uniform_block_bindings)
+				Gpu::BindUniformBlock(gp.gpu_handle, i.first, i.second);
+
+			gp.uniform_owner = nullptr;
+			for(ProgramDataHolder* i : gp.users) RebuildUniformTable(*i);
+		}
+
+		//A uniform, that the linker removed, is still in the source. One, that isn't, is most likely misspelled
+		void CheckUniformDeclared(const GpuProgram& gp, std::string_view name){
+			const std::string base_name(name.substr(0, name.find_first_of("[.")));
+			if(gp.vs_src.find(base_name) == std::string::npos && gp.fs_src.find(base_name) == std::string::npos &&
+			   gp.cs_src.find(base_name) == std::string::npos)
+				throw std::runtime_error("Uniform \"" + std::string(name) + "\" is not declared in the shader program");
+		}
+
+		inline uint32 GetUniformSlot(ProgramDataHolder& dat, std::string_view name, Gpu::UniformType type){
+			UniformNameMap<uint32>::iterator iter = dat.uniform_slot_ids.find(name);
+			if(iter != dat.uniform_slot_ids.end()){
+				UniformSlot& slot = dat.uniform_slots[iter->second];
+				if(slot.type != type){ //The untyped path allows that, the value is stored again
+					slot.type = type;
+					slot.element_count = 0;
+				}
+				return iter->second;
+			}
+			const int32 location = ResolveUniformLocation(dat, name);
+#ifndef NDEBUG
+			if(location == -1 && dat.gpu != nullptr && !dat.gpu->is_pending) CheckUniformDeclared(*dat.gpu, name);
+#endif
+			dat.uniform_slots.push_back({std::string(name), type, location});
+			dat.uniform_slot_ids.insert({std::string(name), (uint32)dat.uniform_slots.size() - 1});
+			return dat.uniform_slots.size() - 1;
+		}
+
+		//Packs the regions of the slots together, once more than half of the shadow is unused
+		void CompactUniformShadow(ProgramDataHolder& dat){
+			if(dat.uniform_shadow_waste * 2 <= dat.uniform_shadow.size()) return;
+
+			std::vector<uint8> shadow;
+			shadow.reserve(dat.uniform_shadow.size() - dat.uniform_shadow_waste);
+			for(UniformSlot& i : dat.uniform_slots){
+				if(i.data_capacity == 0) continue;
+				const uint8* region = dat.uniform_shadow.data() + i.data_offset;
+				i.data_offset = shadow.size();
+				shadow.insert(shadow.end(), region, region + i.data_capacity);
+			}
+			dat.uniform_shadow.swap(shadow);
+			dat.uniform_shadow_waste = 0;
+		}
+
+		//Writes, that don't change the value, are dropped
+		inline void WriteUniform(ProgramDataHolder& dat, uint32 slot_id, const void* data, size_t element_count){
+			UniformSlot& slot = dat.uniform_slots[slot_id];
+			const size_t data_size = Gpu::type_size_table[(int32)slot.type] * element_count;
+
+			if(slot.element_count == element_count){
+				if(memcmp(dat.uniform_shadow.data() + slot.data_offset, data, data_size) == 0) return;
+			}
+			else if(data_size <= slot.data_capacity) slot.element_count = element_count;
+			else{
+				//Doesn't fit, the slot moves to a new region at the end(twice as big, so an array, whose length
+				//keeps changing, settles quickly) and the old one is reclaimed by the next compaction
+				dat.uniform_shadow_waste += slot.data_capacity;
+				slot.data_capacity = std::max<size_t>(data_size, (size_t)slot.data_capacity * 2);
+				slot.data_offset = dat.uniform_shadow.size();
+				slot.element_count = element_count;
+				dat.uniform_shadow.resize(dat.uniform_shadow.size() + slot.data_capacity);
+				CompactUniformShadow(dat);
+			}
+			FlushPendingBatches(); //They were recorded with the old value
+			memcpy(dat.uniform_shadow.data() + slot.data_offset, data, data_size);
+
+			if(!slot.is_dirty){
+				slot.is_dirty = true;
+				dat.dirty_uniform_slots.push_back(slot_id);
+			}
+		}
+
+		//Another program, that shares the GpuProgram, was drawn last. Its values are replaced by the ones of "dat",
+		//the uniforms, that only it has set, get their post-link values back, as they would in a program of its own.
+		//Only the values, that differ from what GL has, are actually sent
+		void TakeUniformOwnership(ProgramDataHolder& dat){
+			GpuProgram& gp = *dat.gpu;
+			if(gp.uniform_owner != nullptr){
+				for(const UniformSlot& i : gp.uniform_owner->uniform_slots){
+					if(i.element_count == 0 || i.location == -1) continue;
+					UniformNameMap<uint32>::iterator iter = dat.uniform_slot_ids.find(i.name);
+					if(iter != dat.uniform_slot_ids.end() && dat.uniform_slots[iter->second].element_count != 0) continue;
+
+					RestoreUniformDefault(gp, i.location, i.name, i.element_count);
+				}
+			}
+			gp.uniform_owner = &dat;
+
+			for(uint32 i = 0; i < dat.uniform_slots.size(); i++){
+				UniformSlot& slot = dat.uniform_slots[i];
+				if(slot.element_count == 0 || slot.is_dirty) continue;
+				slot.is_dirty = true;
+				dat.dirty_uniform_slots.push_back(i);
+			}
+		}
+
+		//Called by the draws right after binding the program
+		inline void CommitUniforms(ProgramDataHolder& dat){
+			if(dat.gpu == nullptr) return;
+			if(dat.gpu->uniform_owner != &dat) TakeUniformOwnership(dat);
+			if(dat.dirty_uniform_slots.empty()) return;
+
+			for(uint32 i : dat.dirty_uniform_slots){
+				UniformSlot& slot = dat.uniform_slots[i];
+				slot.is_dirty = false;
+				if(slot.location == -1) continue; //Optimized out by the driver
+
+				SendUniform(*dat.gpu, slot.location, slot.name, slot.type,
+				            dat.uniform_shadow.data() + slot.data_offset, slot.element_count);
+			}
+			dat.dirty_uniform_slots.clear();
+		}
+
+		//Appended to the sources, when the key of a program is made
+		inline std::string GetFeedbackKey(const GpuProgram& gp){
+			if(gp.feedback_varyings.empty()) return {};
+			std::string key = gp.feedback_interleaved ? std::string(1, '\0') + "interleaved" : std::string(1, '\0') + "separate";
+			for(const std::string& i : gp.feedback_varyings) key += '\0' + i;
+			return key;
+		}
+
+		//Compiles and links the stored sources, or loads the program from the binary cache.
+		//An async build only issues the work, FinishProgram() completes it
+		void BuildProgram(GpuProgram& gp, bool async = false){
+			gp.is_pending = false;
+			const bool use_cache = IsProgramCacheActive();
+			std::string cache_key;
+			if(use_cache){
+				cache_key = gp.is_compute ? GetProgramCacheKey({}, gp.cs_src) :
+				                            GetProgramCacheKey(gp.vs_src, gp.fs_src + GetFeedbackKey(gp));
+				if(LoadCachedProgram(gp.gpu_handle, cache_key)){
+					OnProgramLinked(gp);
+					return;
+				}
+				Gpu::SetProgramBinaryRetrievable(gp.gpu_handle);
+			}
+
+			if(gp.is_compute){
+				if(async){
+					Gpu::CompileShaderAsync(gp.cs_gpu_handle, gp.cs_src);
+					Gpu::LinkComputeProgramAsync(gp.gpu_handle, gp.cs_gpu_handle);
+				}
+				else{
+					Gpu::CompileShader(gp.cs_gpu_handle, gp.cs_src);
+					Gpu::LinkComputeProgram(gp.gpu_handle, gp.cs_gpu_handle);
+				}
+			}
+			else if(async){
+				if(!gp.feedback_varyings.empty())
+					Gpu::SetFeedbackVaryings(gp.gpu_handle, gp.feedback_varyings, gp.feedback_interleaved);
+				Gpu::CompileShaderAsync(gp.vs_gpu_handle, gp.vs_src);
+				Gpu::CompileShaderAsync(gp.fs_gpu_handle, gp.fs_src);
+				Gpu::LinkShaderProgramAsync(gp.gpu_handle, gp.vs_gpu_handle, gp.fs_gpu_handle);
+			}
+			else{
+				if(!gp.feedback_varyings.empty())
+					Gpu::SetFeedbackVaryings(gp.gpu_handle, gp.feedback_varyings, gp.feedback_interleaved);
+				Gpu::CompileShader(gp.vs_gpu_handle, gp.vs_src);
+				Gpu::CompileShader(gp.fs_gpu_handle, gp.fs_src);
+				Gpu::LinkShaderProgram(gp.gpu_handle, gp.vs_gpu_handle, gp.fs_gpu_handle);
+			}
+
+			if(async){
+				gp.is_pending = true;
+				gp.pending_cache_key = std::move(cache_key);
+				return;
+			}
+			if(use_cache) StoreCachedProgram(gp.gpu_handle, cache_key);
+			OnProgramLinked(gp);
+		}
+		//Waits for the link, if it isn't done yet
+		void FinishProgram(GpuProgram& gp){
+			if(!gp.is_pending) return;
+			gp.is_pending = false;
+
+			if(gp.is_compute) Gpu::FinishProgramLink(gp.gpu_handle, gp.cs_gpu_handle, gp.cs_gpu_handle);
+			else Gpu::FinishProgramLink(gp.gpu_handle, gp.vs_gpu_handle, gp.fs_gpu_handle);
+			if(!gp.pending_cache_key.empty()){
+				StoreCachedProgram(gp.gpu_handle, gp.pending_cache_key);
+				gp.pending_cache_key.clear();
+			}
+			OnProgramLinked(gp);
+		}
+		inline bool PollProgram(GpuProgram& gp){
+			if(!gp.is_pending) return true;
+			if(!Gpu::IsProgramLinkComplete(gp.gpu_handle)) return false;
+			FinishProgram(gp);
+			return true;
+		}
+
+		//Replaces a pending program with its fallback(which is waited for). False means the draw has to be skipped
+		inline bool ResolveDrawProgram(ShaderProgram::Handle& prg){
+			if(prg.data == nullptr || prg.data->gpu == nullptr || PollProgram(*prg.data->gpu)) return true;
+			if(prg.data->fallback == nullptr) return false;
+
+			prg.data = prg.data->fallback;
+			if(prg.data->gpu != nullptr) FinishProgram(*prg.data->gpu);
+			return true;
+		}
+
+		inline uint64 GetProgramKey(const std::string& vertex_source, const std::string& fragment_source)
+			{ return HashFnv1a(std::string(1, '\0') + fragment_source, HashFnv1a(vertex_source)); }
+
+		inline bool IsSameSource(const GpuProgram& a, const GpuProgram& b)
+			{ return a.is_compute == b.is_compute && a.vs_src == b.vs_src && a.fs_src == b.fs_src && a.cs_src == b.cs_src &&
+			         a.feedback_varyings == b.feedback_varyings && a.feedback_interleaved == b.feedback_interleaved; }
+
+		void MakeGpuObjects(GpuProgram& gp){
+			gp.gpu_handle = Gpu::MakeShaderProgram();
+			if(gp.is_compute) gp.cs_gpu_handle = Gpu::MakeShader(Gpu::ShaderType::COMPUTE);
+			else{
+				gp.vs_gpu_handle = Gpu::MakeShader(Gpu::ShaderType::VERTEX);
+				gp.fs_gpu_handle = Gpu::MakeShader(Gpu::ShaderType::FRAGMENT);
+			}
+		}
+		void DeleteGpuObjects(GpuProgram& gp){
+			Gpu::DeleteShaderProgram(gp.gpu_handle);
+			if(gp.is_compute) Gpu::DeleteShader(gp.cs_gpu_handle);
+			else{
+				Gpu::DeleteShader(gp.vs_gpu_handle);
+				Gpu::DeleteShader(gp.fs_gpu_handle);
+			}
+		}
+
+		//Returns the registered GpuProgram with the same sources, or builds "source"(which is only a description)
+		GpuProgram* AcquireGpuProgram(GpuProgram&& source, bool async){
+			source.key = source.is_compute ? GetProgramKey({}, source.cs_src) :
+			                                 GetProgramKey(source.vs_src, source.fs_src + GetFeedbackKey(source));
+			std::unordered_map<uint64, GpuProgram*>::iterator iter = gpu_program_registry.find(source.key);
+			if(iter != gpu_program_registry.end() && IsSameSource(*iter->second, source)){
+				GpuProgram& gp = *iter->second;
+				if(!async){
+					gp.is_async = false;
+					FinishProgram(gp);
+				}
+				return &gp;
+			}
+
+			GpuProgram* gp = new GpuProgram(std::move(source));
+			MakeGpuObjects(*gp);
+			gp->is_async = async;
+			gp->is_registered = iter == gpu_program_registry.end();
+
+			all_gpu_programs.insert(gp);
+			if(gp->is_registered) gpu_program_registry.insert({gp->key, gp});
+			BuildProgram(*gp, async);
+			return gp;
+		}
+		inline GpuProgram* AcquireGpuProgram(const std::string& vertex_source, const std::string& fragment_source, bool async){
+			GpuProgram source;
+			source.vs_src = vertex_source;
+			source.fs_src = fragment_source;
+			return AcquireGpuProgram(std::move(source), async);
+		}
+		void ReleaseGpuProgram(ProgramDataHolder& dat){
+			if(dat.gpu == nullptr) return;
+			GpuProgram* gp = dat.gpu;
+			dat.gpu = nullptr;
+
+			std::erase(gp->users, &dat);
+			if(gp->uniform_owner == &dat) gp->uniform_owner = nullptr;
+			if(!gp->users.empty()) return;
+
+			DeleteGpuObjects(*gp);
+			if(gp->is_registered) gpu_program_registry.erase(gp->key);
+			all_gpu_programs.erase(gp);
+			delete gp;
+		}
+		void AttachGpuProgram(ProgramDataHolder& dat, GpuProgram* gp){
+			if(dat.gpu == gp) return;
+			ReleaseGpuProgram(dat);
+			gp->users.push_back(&dat);
+			dat.gpu = gp;
+			dat.is_linked = true;
+			RebuildUniformTable(dat);
+		}
+
+		bool parallel_compile_supported = false;
 
 		inline void RebindBoundShader(){
-			Gpu::BindShaderProgram(get_ro_pr_data(bound_shader).gpu_handle);
+			Gpu::BindShaderProgram(GetGpuHandle(get_ro_pr_data(bound_shader)));
 		}
 		void InitializeShaders(){
 			Gpu::MakeShader = Gpu::Opengl33::MakeShader;
@@ -67,30 +529,41 @@ namespace LLJGFX{
 			Gpu::MakeShaderProgram = Gpu::Opengl33::MakeShaderProgram;
 			Gpu::DeleteShaderProgram = Gpu::Opengl33::DeleteShaderProgram;
 			Gpu::LinkShaderProgram = Gpu::Opengl33::LinkShaderProgram;
+			Gpu::LinkComputeProgram = Gpu::Opengl33::LinkComputeProgram;
+			Gpu::SetFeedbackVaryings = Gpu::Opengl33::SetFeedbackVaryings;
 
 			Gpu::SetUniform = Gpu::Opengl33::SetUniform;
+			Gpu::SetUniformAt = Gpu::Opengl33::SetUniformAt;
+			Gpu::GetUniformLocation = Gpu::Opengl33::GetUniformLocation;
+			Gpu::GetUniformValue = Gpu::Opengl33::GetUniformValue;
+			Gpu::BindUniformBlock = Gpu::Opengl33::BindUniformBlock;
+			Gpu::QueryProgramReflection = Gpu::Opengl33::QueryProgramReflection;
 
-			for(ProgramDataHolder* i : all_program_handles){
-				const HandleType old_handle = i->gpu_handle;
+			Gpu::IsProgramBinarySupported = Gpu::Opengl33::IsProgramBinarySupported;
+			Gpu::GetDriverString = Gpu::Opengl33::GetDriverString;
+			Gpu::SetProgramBinaryRetrievable = Gpu::Opengl33::SetProgramBinaryRetrievable;
+			Gpu::GetProgramBinary = Gpu::Opengl33::GetProgramBinary;
+			Gpu::LoadProgramBinary = Gpu::Opengl33::LoadProgramBinary;
+			InitializeProgramCache();
 
-				i->gpu_handle = Gpu::MakeShaderProgram();
+			Gpu::CompileShaderAsync = Gpu::Opengl33::CompileShaderAsync;
+			Gpu::LinkShaderProgramAsync = Gpu::Opengl33::LinkShaderProgramAsync;
+			Gpu::LinkComputeProgramAsync = Gpu::Opengl33::LinkComputeProgramAsync;
+			Gpu::EnableParallelCompile = Gpu::Opengl33::EnableParallelCompile;
+			Gpu::IsProgramLinkComplete = Gpu::Opengl33::IsProgramLinkComplete;
+			Gpu::FinishProgramLink = Gpu::Opengl33::FinishProgramLink;
+			parallel_compile_supported = Gpu::EnableParallelCompile();
 
-				i->bound_vs_gpu_handle = Gpu::MakeShader(Gpu::ShaderType::VERTEX);
-				i->bound_fs_gpu_handle = Gpu::MakeShader(Gpu::ShaderType::FRAGMENT);
-
-				if(i->is_linked) {
-					Gpu::CompileShader(i->bound_vs_gpu_handle, i->bound_vs_src);
-					Gpu::CompileShader(i->bound_fs_gpu_handle, i->bound_fs_src);
-					Gpu::LinkShaderProgram(i->gpu_handle, i->bound_vs_gpu_handle, i->bound_fs_gpu_handle);
-
-					const Gpu::PreInit::PI_SP& pi_dat = Gpu::PreInit::pi_sps.find(old_handle)->second;
-
-					for(const std::pair<const std::string, Gpu::PreInit::PI_UF>& c_uf : pi_dat.uniforms)
-						Gpu::SetUniform(i->gpu_handle, c_uf.first, c_uf.second.type,
-										(const char*)c_uf.second.data.data(),
-										c_uf.second.data.size() / Gpu::type_size_table[(int32)c_uf.second.type]);
-				}
+			//Everything is issued before anything is waited for, so the driver can build the programs in parallel.
+			//The uniforms, that were set before, are in the shadow copies and are sent again by RebuildUniformTable()
+			for(GpuProgram* i : all_gpu_programs){
+				MakeGpuObjects(*i);
+				BuildProgram(*i, true);
 			}
+			//Programs, that were compiled synchronously, are expected to be usable right away
+			for(GpuProgram* i : all_gpu_programs)
+				if(!i->is_async) FinishProgram(*i);
+
 			RebindBoundShader();
 			Gpu::PreInit::pi_sps.clear();
 			Gpu::PreInit::sh_last_handle = 1;
@@ -98,29 +571,128 @@ namespace LLJGFX{
 	}
 
 	namespace ShaderProgram {
+		//Programs with identical sources share the GL program, only the uniform values are their own
 		inline void Compile(Handle program_handle, const std::string& vertex_shader_source, const std::string& fragment_shader_source){
 #ifndef NDEBUG
 			Internal::CheckProgramValidity(program_handle);
 #endif
-			Internal::ProgramDataHolder& dat = *program_handle.data;
+			Internal::AttachGpuProgram(*program_handle.data,
+			                           Internal::AcquireGpuProgram(vertex_shader_source, fragment_shader_source, false));
+		}
+		//Returns before the driver is done. Uniforms can be set meanwhile, draws use the fallback or are skipped
+		//until the program is ready. Only KHR/ARB_parallel_shader_compile lets that be polled, without it the first
+		//draw waits
+		inline void CompileAsync(Handle program_handle, const std::string& vertex_shader_source, const std::string& fragment_shader_source){
+#ifndef NDEBUG
+			Internal::CheckProgramValidity(program_handle);
+#endif
+			Internal::AttachGpuProgram(*program_handle.data,
+			                           Internal::AcquireGpuProgram(vertex_shader_source, fragment_shader_source, true));
+		}
+		//"varyings" are the outputs of the vertex shader, that transform feedback captures(see TransformFeedback::Capture())
+		inline void CompileWithFeedback(Handle program_handle, const std::string& vertex_shader_source, const std::string& fragment_shader_source,
+		                                const std::vector<std::string>& varyings, bool interleaved = true){
+#ifndef NDEBUG
+			Internal::CheckProgramValidity(program_handle);
+			if(varyings.empty()) throw std::runtime_error("Transform feedback needs at least one varying");
+#endif
+			Internal::GpuProgram source;
+			source.vs_src = vertex_shader_source;
+			source.fs_src = fragment_shader_source;
+			source.feedback_varyings = varyings;
+			source.feedback_interleaved = interleaved;
+			Internal::AttachGpuProgram(*program_handle.data, Internal::AcquireGpuProgram(std::move(source), false));
+		}
+		inline bool HasFeedback(Handle program_handle) {
+			const Internal::ProgramDataHolder& dat = Internal::get_ro_pr_data(program_handle);
+			return dat.gpu != nullptr && !dat.gpu->feedback_varyings.empty();
+		}
 
-			dat.is_linked = true;
-			dat.bound_vs_src = vertex_shader_source;
-			dat.bound_fs_src = fragment_shader_source;
+		//Needs GL 4.3(or ARB_compute_shader) once the context exists. See Compute::Dispatch()
+		inline void CompileCompute(Handle program_handle, const std::string& compute_shader_source, bool async = false){
+#ifndef NDEBUG
+			Internal::CheckProgramValidity(program_handle);
+#endif
+			Internal::GpuProgram source;
+			source.is_compute = true;
+			source.cs_src = compute_shader_source;
+			Internal::AttachGpuProgram(*program_handle.data, Internal::AcquireGpuProgram(std::move(source), async));
+		}
+		inline bool IsCompute(Handle program_handle) {
+			const Internal::ProgramDataHolder& dat = Internal::get_ro_pr_data(program_handle);
+			return dat.gpu != nullptr && dat.gpu->is_compute;
+		}
 
-			Internal::Gpu::CompileShader(dat.bound_vs_gpu_handle, vertex_shader_source);
-			Internal::Gpu::CompileShader(dat.bound_fs_gpu_handle, fragment_shader_source);
-			Internal::Gpu::LinkShaderProgram(dat.gpu_handle, dat.bound_vs_gpu_handle, dat.bound_fs_gpu_handle);
+		//Makes "program_handle" use the GL program of "source_handle" without compiling anything. Uniforms aren't copied
+		inline void Share(Handle program_handle, Handle source_handle){
+#ifndef NDEBUG
+			Internal::CheckProgramValidity(program_handle);
+			Internal::CheckProgramValidity(source_handle);
+#endif
+			if(source_handle.data->gpu == nullptr){
+				Internal::ReleaseGpuProgram(*program_handle.data);
+				program_handle.data->is_linked = false;
+			}
+			else Internal::AttachGpuProgram(*program_handle.data, source_handle.data->gpu);
+		}
+
+		//Doesn't wait
+		inline bool IsReady(Handle program_handle){
+#ifndef NDEBUG
+			Internal::CheckProgramValidity(program_handle);
+#endif
+			return program_handle.data->gpu != nullptr && Internal::PollProgram(*program_handle.data->gpu);
+		}
+		inline void Wait(Handle program_handle){
+#ifndef NDEBUG
+			Internal::CheckProgramValidity(program_handle);
+#endif
+			if(program_handle.data->gpu != nullptr) Internal::FinishProgram(*program_handle.data->gpu);
+		}
+		//Null means pending draws are skipped
+		inline void SetFallback(Handle program_handle, Handle fallback_handle){
+#ifndef NDEBUG
+			Internal::CheckProgramValidity(program_handle);
+			if(fallback_handle.data != nullptr) Internal::CheckProgramValidity(fallback_handle);
+			if(fallback_handle.data == program_handle.data)
+				throw std::runtime_error("A shader program can't be its own fallback");
+#endif
+			program_handle.data->fallback = fallback_handle.data;
+		}
+		//Waits for an async program
+		inline const ProgramReflection& GetReflection(Handle program_handle){
+#ifndef NDEBUG
+			Internal::CheckProgramValidity(program_handle);
+#endif
+			if(program_handle.data->gpu == nullptr)
+				throw std::runtime_error("Trying to get the reflection of a shader program that wasn't compiled");
+			Internal::FinishProgram(*program_handle.data->gpu);
+			return program_handle.data->gpu->reflection;
+		}
+		//-1 if the program has no such sampler
+		inline int32 GetSamplerUnit(Handle program_handle, const std::string& sampler){
+			for(const ShaderSampler& i : GetReflection(program_handle).samplers)
+				if(i.name == sampler || i.name == sampler + "[0]") return i.unit;
+			return -1;
+		}
+		inline bool HasUniform(Handle program_handle, const std::string& uniform){
+			GetReflection(program_handle);
+			const Internal::UniformNameMap<int32>& locations = program_handle.data->gpu->uniform_locations;
+			Internal::UniformNameMap<int32>::const_iterator iter = locations.find(uniform);
+			return iter != locations.end() && iter->second != -1; //Misses are cached as -1
+		}
+
+		inline bool IsParallelCompileSupported() { return Internal::parallel_compile_supported; }
+
+		//Number of programs using the same GL program, 0 if it isn't compiled
+		inline size_t GetShareCount(Handle program_handle){
+			const Internal::ProgramDataHolder& dat = Internal::get_ro_pr_data(program_handle);
+			return dat.gpu != nullptr ? dat.gpu->users.size() : 0;
 		}
 
 		inline Handle Make() {
 			Handle handle = { new Internal::ProgramDataHolder{} };
 			Internal::all_program_handles.insert(handle.data);
-			Internal::ProgramDataHolder& dat = *handle.data;
-
-			dat.gpu_handle = Internal::Gpu::MakeShaderProgram();
-			dat.bound_vs_gpu_handle = Internal::Gpu::MakeShader(Internal::Gpu::ShaderType::VERTEX);
-			dat.bound_fs_gpu_handle = Internal::Gpu::MakeShader(Internal::Gpu::ShaderType::FRAGMENT);
 			return handle;
 		}
 		inline Handle Make(const std::string& vertex_shader_source, const std::string& fragment_shader_source) {
@@ -135,25 +707,32 @@ namespace LLJGFX{
 #ifndef NDEBUG
 			Internal::CheckProgramValidity(program_handle);
 #endif
-			Internal::ProgramDataHolder& dat = *program_handle.data;
-			Internal::Gpu::DeleteShaderProgram(dat.gpu_handle);
-			Internal::Gpu::DeleteShader(dat.bound_vs_gpu_handle);
-			Internal::Gpu::DeleteShader(dat.bound_fs_gpu_handle);
+			Internal::ReleaseGpuProgram(*program_handle.data);
 
+			Internal::all_program_handles.erase(program_handle.data);
+			for(Internal::ProgramDataHolder* i : Internal::all_program_handles)
+				if(i->fallback == program_handle.data) i->fallback = nullptr;
 			delete program_handle.data;
 		}
 
 		inline void Bind(Handle program_handle) {
+			Internal::FlushPendingBatches();
 			Internal::bound_shader = program_handle;
-			Internal::Gpu::BindShaderProgram(Internal::get_ro_pr_data(program_handle).gpu_handle);
+			Internal::Gpu::BindShaderProgram(Internal::GetGpuHandle(Internal::get_ro_pr_data(program_handle)));
 		}
 
-		inline std::string GetAttachedVertexShader(Handle program_handle)
-			{ return Internal::get_ro_pr_data(program_handle).bound_vs_src; }
-		inline std::string GetAttachedFragmentShader(Handle program_handle)
-			{ return Internal::get_ro_pr_data(program_handle).bound_fs_src; }
+		inline std::string GetAttachedVertexShader(Handle program_handle){
+			const Internal::ProgramDataHolder& dat = Internal::get_ro_pr_data(program_handle);
+			return dat.gpu != nullptr ? dat.gpu->vs_src : std::string();
+		}
+		inline std::string GetAttachedFragmentShader(Handle program_handle){
+			const Internal::ProgramDataHolder& dat = Internal::get_ro_pr_data(program_handle);
+			return dat.gpu != nullptr ? dat.gpu->fs_src : std::string();
+		}
 
-		template<typename T> inline void SetUniform(Handle program_handle, const std::string& uniform, const T* data, size_t element_count) {
+		//Untyped version, used by everything that has to store uniforms before setting them(e.g. command buffers)
+		inline void SetUniform(Handle program_handle, std::string_view uniform, Internal::Gpu::UniformType type,
+		                       const void* data, size_t element_count) {
 #ifndef NDEBUG
 			Internal::CheckProgramValidity(program_handle);
 #endif
@@ -162,11 +741,49 @@ namespace LLJGFX{
 			if(!dat.is_linked)
 				throw std::runtime_error("Trying to set uniform for a shader program that wasn't compiled");
 
-			Internal::Gpu::SetUniform(dat.gpu_handle, uniform, Internal::Gpu::DeduceUfType<T>(), (const void*)data, element_count);
+			Internal::WriteUniform(dat, Internal::GetUniformSlot(dat, uniform, type), data, element_count);
 		}
+		template<typename T> inline void SetUniform(Handle program_handle, const std::string& uniform, const T* data, size_t element_count)
+			{ SetUniform(program_handle, uniform, Internal::Gpu::DeduceUfType<T>(), (const void*)data, element_count); }
 		template<typename T> inline void SetUniform(Handle program_handle, const std::string& uniform, const T& data)
 			{ SetUniform(program_handle, uniform, &data, 1); }
 		template<typename T> inline void SetUniform(Handle program_handle, const std::string& uniform, const std::vector<T>& data)
 			{ SetUniform(program_handle, uniform, data.data(), data.size()); }
+
+		//Sends the changed uniforms right away, draws do it by themselves
+		inline void CommitUniforms(Handle program_handle){
+#ifndef NDEBUG
+			Internal::CheckProgramValidity(program_handle);
+#endif
+			Internal::CommitUniforms(*program_handle.data);
+		}
+
+		//Looked up once, setting through the handle skips the name lookup
+		template<typename T> inline UniformHandle<T> GetUniform(Handle program_handle, const std::string& uniform){
+			static_assert(Internal::Gpu::DeduceUfType<T>() != Internal::Gpu::UniformType::INVALID, "Unsupported uniform type");
+#ifndef NDEBUG
+			Internal::CheckProgramValidity(program_handle);
+#endif
+			Internal::ProgramDataHolder& dat = *program_handle.data;
+			constexpr Internal::Gpu::UniformType type = Internal::Gpu::DeduceUfType<T>();
+
+			Internal::UniformNameMap<uint32>::iterator iter = dat.uniform_slot_ids.find(uniform);
+			if(iter != dat.uniform_slot_ids.end() && dat.uniform_slots[iter->second].type != type)
+				throw std::runtime_error("Uniform \"" + uniform + "\" was already used with another type");
+			return { program_handle.data, Internal::GetUniformSlot(dat, uniform, type) };
+		}
+
+		template<typename T> inline void SetUniform(UniformHandle<T> uniform, const T* data, size_t element_count){
+#ifndef NDEBUG
+			Internal::CheckProgramValidity({uniform.program});
+			if(!uniform.program->is_linked)
+				throw std::runtime_error("Trying to set uniform for a shader program that wasn't compiled");
+#endif
+			Internal::WriteUniform(*uniform.program, uniform.slot, (const void*)data, element_count);
+		}
+		template<typename T> inline void SetUniform(UniformHandle<T> uniform, const T& data)
+			{ SetUniform(uniform, &data, 1); }
+		template<typename T> inline void SetUniform(UniformHandle<T> uniform, const std::vector<T>& data)
+			{ SetUniform(uniform, data.data(), data.size()); }
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,150 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+
+#include "Shader.h"
+
+//One source with a list of #define keywords. Every combination(a bitmask of the keywords) is its own program,
+//built the first time it's requested or ahead of time with Precompile(). Variants are built asynchronously and
+//drawn with the base variant(no keywords) until they are ready
+namespace LLJGFX{
+	namespace Internal{
+		struct ShaderFamilyDataHolder{
+			std::string vs_src;
+			std::string fs_src;
+			std::vector<std::string> keywords; //Bit i of a mask is keywords[i]
+
+			std::unordered_map<uint32, ShaderProgram::Handle> variants;
+			ShaderProgram::Handle base_variant = { nullptr };
+		};
+
+		std::unordered_set<ShaderFamilyDataHolder*> all_shader_family_handles;
+
+		void CheckShaderFamilyValidity(ShaderFamilyDataHolder* data){
+			if(!all_shader_family_handles.contains(data))
+				throw std::runtime_error(data == nullptr ?
+				                         "Non-existent shader family was requested using uninitialized handle" :
+				                         "Deleted shader family was requested");
+		}
+
+		//The defines go right after #version(which must stay first), #line keeps the line numbers of the errors
+		std::string InjectDefines(const std::string& source, const std::vector<std::string>& keywords, uint32 mask){
+			if(mask == 0) return source;
+
+			std::string defines;
+			for(uint32 i = 0; i < keywords.size(); i++)
+				if(mask & (1u << i)) defines += "#define " + keywords[i] + "\n";
+
+			size_t insert_pos = 0;
+			const size_t version_pos = source.find("#version");
+			if(version_pos != std::string::npos){
+				const size_t line_end = source.find('\n', version_pos);
+				insert_pos = line_end == std::string::npos ? source.size() : line_end + 1;
+			}
+			std::string result = source.substr(0, insert_pos);
+			if(insert_pos != 0 && result.back() != '\n') result += '\n';
+			const size_t line = std::count(result.begin(), result.end(), '\n') + 1;
+			result += defines + "#line " + std::to_string(line) + "\n";
+			result.append(source, insert_pos, std::string::npos);
+			return result;
+		}
+
+		//Unknown bits are dropped, so they don't make duplicate variants
+		inline uint32 MaskKeywords(const ShaderFamilyDataHolder& dat, uint32 mask)
+			{ return mask & (dat.keywords.size() == 32 ? ~0u : (1u << dat.keywords.size()) - 1); }
+
+		ShaderProgram::Handle BuildVariant(ShaderFamilyDataHolder& dat, uint32 mask){
+			const ShaderProgram::Handle variant = ShaderProgram::Make();
+			if(mask == 0) ShaderProgram::Compile(variant, dat.vs_src, dat.fs_src);
+			else{
+				ShaderProgram::CompileAsync(variant, InjectDefines(dat.vs_src, dat.keywords, mask),
+				                            InjectDefines(dat.fs_src, dat.keywords, mask));
+				ShaderProgram::SetFallback(variant, dat.base_variant);
+			}
+			dat.variants.insert({mask, variant});
+			return variant;
+		}
+	}
+
+	namespace ShaderFamily{
+		struct Handle{
+			Internal::ShaderFamilyDataHolder* data = nullptr;
+		};
+
+		inline bool IsValid(Handle handle) { return Internal::all_shader_family_handles.contains(handle.data); }
+
+		//The base variant is compiled right away
+		inline Handle Make(const std::string& vertex_shader_source, const std::string& fragment_shader_source,
+		                   const std::vector<std::string>& keywords){
+			if(keywords.size() > 32)
+				throw std::runtime_error("A shader family can't have more than 32 keywords");
+
+			Handle handle = { new Internal::ShaderFamilyDataHolder{} };
+			Internal::all_shader_family_handles.insert(handle.data);
+			handle.data->vs_src = vertex_shader_source;
+			handle.data->fs_src = fragment_shader_source;
+			handle.data->keywords = keywords;
+			handle.data->base_variant = Internal::BuildVariant(*handle.data, 0);
+			return handle;
+		}
+		inline void Delete(Handle family_handle){
+			if(family_handle.data == nullptr) return;
+#ifndef NDEBUG
+			Internal::CheckShaderFamilyValidity(family_handle.data);
+#endif
+			for(const std::pair<const uint32, ShaderProgram::Handle>& i : family_handle.data->variants)
+				ShaderProgram::Delete(i.second);
+
+			Internal::all_shader_family_handles.erase(family_handle.data);
+			delete family_handle.data;
+		}
+
+		//Bit of the keyword, meant to be looked up once
+		inline uint32 GetKeywordMask(Handle family_handle, const std::string& keyword){
+#ifndef NDEBUG
+			Internal::CheckShaderFamilyValidity(family_handle.data);
+#endif
+			const std::vector<std::string>& keywords = family_handle.data->keywords;
+			for(uint32 i = 0; i < keywords.size(); i++)
+				if(keywords[i] == keyword) return 1u << i;
+			throw std::runtime_error("Shader family has no keyword \"" + keyword + "\"");
+		}
+
+		//Starts building the variants in the background, unknown bits are ignored as in GetVariant()
+		inline void Precompile(Handle family_handle, const std::vector<uint32>& masks){
+#ifndef NDEBUG
+			Internal::CheckShaderFamilyValidity(family_handle.data);
+#endif
+			Internal::ShaderFamilyDataHolder& dat = *family_handle.data;
+			for(uint32 i : masks){
+				const uint32 mask = Internal::MaskKeywords(dat, i);
+				if(!dat.variants.contains(mask)) Internal::BuildVariant(dat, mask);
+			}
+		}
+
+		//Unknown bits are ignored. The handle is owned by the family and stays valid until it's deleted
+		inline ShaderProgram::Handle GetVariant(Handle family_handle, uint32 mask){
+#ifndef NDEBUG
+			Internal::CheckShaderFamilyValidity(family_handle.data);
+#endif
+			Internal::ShaderFamilyDataHolder& dat = *family_handle.data;
+			mask = Internal::MaskKeywords(dat, mask);
+
+			std::unordered_map<uint32, ShaderProgram::Handle>::iterator iter = dat.variants.find(mask);
+			if(iter != dat.variants.end()) return iter->second;
+			return Internal::BuildVariant(dat, mask);
+		}
+		inline bool IsVariantReady(Handle family_handle, uint32 mask)
+			{ return ShaderProgram::IsReady(GetVariant(family_handle, mask)); }
+
+		inline size_t GetVariantCount(Handle family_handle){
+#ifndef NDEBUG
+			Internal::CheckShaderFamilyValidity(family_handle.data);
+#endif
+			return family_handle.data->variants.size();
+		}
+	}
+}
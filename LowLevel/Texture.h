@@ -29,6 +29,10 @@ namespace LLJGFX {
 			Gpu::MakeTexture = Gpu::Opengl33::MakeTexture;
 			Gpu::DeleteTexture = Gpu::Opengl33::DeleteTexture;
 			Gpu::SetTextureData = Gpu::Opengl33::SetTextureData;
+			Gpu::SetTextureSubData = Gpu::Opengl33::SetTextureSubData;
+			Gpu::AllocateTextureStorage = Gpu::Opengl33::AllocateTextureStorage;
+			Gpu::IsClearTextureSupported = Gpu::Opengl33::IsClearTextureSupported;
+			Gpu::ClearTexture = Gpu::Opengl33::ClearTexture;
 			Gpu::GetTextureData = Gpu::Opengl33::GetTextureData;
 			Gpu::SetTextureFilteringMode = Gpu::Opengl33::SetTextureFilteringMode;
 			Gpu::SetTextureWrapMode = Gpu::Opengl33::SetTextureWrapMode;
@@ -41,6 +45,11 @@ namespace LLJGFX {
 			Gpu::BindRenderbufferToFramebuffer = Gpu::Opengl33::BindRenderbufferToFramebuffer;
 			Gpu::BindTextureToFramebuffer = Gpu::Opengl33::BindTextureToFramebuffer;
 
+			Gpu::IsGpuCopySupported = Gpu::Opengl33::IsGpuCopySupported;
+			Gpu::IsImageCopySupported = Gpu::Opengl33::IsImageCopySupported;
+			Gpu::CopyImage = Gpu::Opengl33::CopyImage;
+			Gpu::BlitFramebuffer = Gpu::Opengl33::BlitFramebuffer;
+
 			for(TxtDataHolder* i : all_txt_handles){
 				const Gpu::PreInit::PI_TextureData& pi_data = Gpu::PreInit::txt_data[i->texture_gpu_handle];
 
@@ -78,7 +87,18 @@ namespace LLJGFX {
 			return *txt_handle.data;
 		}
 
-		Texture::Handle bound_framebuffer_texture = { nullptr };
+		thread_local Texture::Handle bound_framebuffer_texture = { nullptr }; //Per thread, like curr_context
+
+		//The depth-stencil renderbuffer and the viewport follow the size of the texture
+		inline void OnTextureResized(Texture::Handle txt_handle, pos2du16 size){
+			TxtDataHolder& dat = *txt_handle.data;
+			dat.size = size;
+			if(dat.bound_renderbuffer != INVALID_HANDLE)
+				Gpu::ResizeRenderbuffer( dat.bound_renderbuffer, size);
+
+			if(txt_handle.data == bound_framebuffer_texture.data)
+				Gpu::SetViewportSize(size);
+		}
 	}
 
 	namespace Texture {
@@ -86,15 +106,9 @@ namespace LLJGFX {
 #ifndef NDEBUG
 			Internal::CheckTextureValidity(txt_handle);
 #endif
-			Internal::TxtDataHolder& dat = *txt_handle.data;
-			Internal::Gpu::SetTextureData(dat.texture_gpu_handle, data, size);
-
-			dat.size = size;
-			if(dat.bound_renderbuffer != INVALID_HANDLE)
-				Internal::Gpu::ResizeRenderbuffer( dat.bound_renderbuffer, size);
-
-			if(txt_handle.data == Internal::bound_framebuffer_texture.data)
-				Internal::Gpu::SetViewportSize(size);
+			Internal::FlushPendingBatches();
+			Internal::Gpu::SetTextureData(txt_handle.data->texture_gpu_handle, data, size);
+			Internal::OnTextureResized(txt_handle, size);
 		}
 		inline void SetData(Handle txt_handle, const std::string &data, pos2du16 size)
 			{ SetData(txt_handle, (const uint8 *) data.data(), size); }
@@ -116,16 +130,11 @@ namespace LLJGFX {
 			SetData(txt_handle, converted, size_adapter);
 			stbi_image_free(converted);
 		}
-		inline void Resize(Handle txt_handle, pos2du16 new_size){ //for usage as a framebuffer
-			Texture::SetData(txt_handle,
-			                 std::string(new_size.x * new_size.y * JGFX::PIXEL_BINARY_SIZE, (char)0),
-			                 new_size);
-		}
-
 		inline void SetFilteringMode(Handle txt_handle, JGFX::TxtFiltMode mode) {
 #ifndef NDEBUG
 			Internal::CheckTextureValidity(txt_handle);
 #endif
+			Internal::FlushPendingBatches();
 			Internal::Gpu::SetTextureFilteringMode(txt_handle.data->texture_gpu_handle, mode);
 			txt_handle.data->filtering = mode;
 		}
@@ -133,6 +142,7 @@ namespace LLJGFX {
 #ifndef NDEBUG
 			Internal::CheckTextureValidity(txt_handle);
 #endif
+			Internal::FlushPendingBatches();
 			Internal::Gpu::SetTextureWrapMode(txt_handle.data->texture_gpu_handle, mode);
 			txt_handle.data->wrapping = mode;
 		}
@@ -154,11 +164,6 @@ namespace LLJGFX {
 		}
 		inline pos2du16 GetSize(Handle txt_handle) { return Internal::get_ro_txt_data(txt_handle).size; }
 
-		inline void Copy(Handle to, Handle from) {
-			LLJGFX::Texture::SetData(to, LLJGFX::Texture::GetData(from), LLJGFX::Texture::GetSize(from));
-			LLJGFX::Texture::SetModes(to, LLJGFX::Texture::GetFilteringMode(from), LLJGFX::Texture::GetWrapMode(from));
-		}
-
 		inline Handle Make() {
 			Handle handle = { new Internal::TxtDataHolder{} };
 			Internal::all_txt_handles.insert(handle.data);
@@ -193,19 +198,20 @@ namespace LLJGFX {
 #ifndef NDEBUG
 			Internal::CheckTextureValidity(txt_handle);
 #endif
+			Internal::FlushPendingBatches(); //One of them could sample the texture
 			Internal::TxtDataHolder& dat = *txt_handle.data;
 
 			//actions with a framebuffer
 			if(!dat.context_framebuffers.empty()){
 				for(const std::pair<Internal::WindowDataHolder*const, HandleType>& i : dat.context_framebuffers){
-					glfwMakeContextCurrent(i.first->win);
+					Internal::Gpu::State::MakeContextCurrent(i.first->win);
 					Internal::Gpu::DeleteFramebuffer(i.second);
 					i.first->local_framebuffers.erase(txt_handle.data);
 					//Also delete reference from the window
 				}
 				Internal::Gpu::DeleteRenderbuffer(dat.bound_renderbuffer);
 
-				glfwMakeContextCurrent(Internal::curr_context->win);
+				Internal::Gpu::State::MakeContextCurrent(Internal::curr_context->win);
 			}
 			Internal::Gpu::DeleteTexture(dat.texture_gpu_handle);
 
@@ -231,12 +237,165 @@ namespace LLJGFX {
 			return dat.context_framebuffers[Internal::curr_context];
 		}
 
+		inline pos2du16 GetCurrentWindowSize() { return GetWindowSize(curr_context->win); }
+
+		//Empty framebuffers, that the blits attach their textures to. Framebuffers aren't shared between contexts
+		struct BlitFramebuffers{
+			HandleType read = INVALID_HANDLE;
+			HandleType draw = INVALID_HANDLE;
+		};
+		std::unordered_map<WindowDataHolder*, BlitFramebuffers> blit_framebuffers;
+
+		inline const BlitFramebuffers& GetBlitFramebuffers(){
+			std::unordered_map<WindowDataHolder*, BlitFramebuffers>::iterator iter = blit_framebuffers.find(curr_context);
+			if(iter == blit_framebuffers.end())
+				iter = blit_framebuffers.insert({curr_context, {Gpu::MakeFramebuffer(), Gpu::MakeFramebuffer()}}).first;
+			return iter->second;
+		}
+
 		inline void RebindBoundFramebuffer(){
+			if(bound_framebuffer_texture.data == nullptr){ //The window itself is bound
+				Gpu::BindFramebuffer(0, GetCurrentWindowSize());
+				return;
+			}
 			Gpu::BindFramebuffer(GetTextureFramebufferHandle(bound_framebuffer_texture),
 			                               Texture::GetSize(bound_framebuffer_texture));
 		}
 	}
 
+	//A part of a texture, a zero size means "up to the edge"
+	struct TextureRegion{
+		pos2du16 offset = { 0, 0 };
+		pos2du16 size = { 0, 0 };
+	};
+
+	namespace Internal{
+		inline TextureRegion ResolveRegion(TextureRegion region, pos2du16 txt_size){
+			if(region.size.x == 0) region.size.x = txt_size.x - region.offset.x;
+			if(region.size.y == 0) region.size.y = txt_size.y - region.offset.y;
+#ifndef NDEBUG
+			if(region.offset.x + region.size.x > txt_size.x || region.offset.y + region.size.y > txt_size.y)
+				throw std::runtime_error("The texture region is out of the texture bounds");
+#endif
+			return region;
+		}
+
+		//Before there is a context the pixels are only on the CPU, so the copy is made there(with nearest filtering)
+		inline void BlitOnCpu(Texture::Handle to, TextureRegion to_region, Texture::Handle from, TextureRegion from_region){
+			const std::string src = Texture::GetData(from);
+			std::string dst = Texture::GetData(to);
+			const pos2du16 src_size = Texture::GetSize(from);
+			const pos2du16 dst_size = Texture::GetSize(to);
+
+			for(uint32 y = 0; y < to_region.size.y; y++){
+				const uint32 src_y = from_region.offset.y + y * from_region.size.y / to_region.size.y;
+				for(uint32 x = 0; x < to_region.size.x; x++){
+					const uint32 src_x = from_region.offset.x + x * from_region.size.x / to_region.size.x;
+					memcpy(dst.data() + ((to_region.offset.y + y) * dst_size.x + to_region.offset.x + x) * JGFX::PIXEL_BINARY_SIZE,
+					       src.data() + (src_y * src_size.x + src_x) * JGFX::PIXEL_BINARY_SIZE, JGFX::PIXEL_BINARY_SIZE);
+				}
+			}
+			Texture::SetData(to, dst, dst_size);
+		}
+	}
+
+	namespace Texture{
+		//Copies a region of "from" into a region of "to", scaled if the sizes differ. A null "to" is the window
+		//of the current context. The pixels stay on the GPU: 1:1 copies between textures use glCopyImageSubData()
+		//when it's there(GL 4.3 or ARB_copy_image), everything else is a framebuffer blit
+		inline void Blit(Handle to, TextureRegion to_region, Handle from, TextureRegion from_region = {}, bool linear = false){
+#ifndef NDEBUG
+			Internal::CheckTextureValidity(from);
+			if(to.data != nullptr) Internal::CheckTextureValidity(to);
+			else if(Internal::curr_context == nullptr) throw std::runtime_error("There is no window to blit to");
+#endif
+			Internal::FlushPendingBatches();
+			const pos2du16 to_size = to.data == nullptr ? Internal::GetCurrentWindowSize() : to.data->size;
+			from_region = Internal::ResolveRegion(from_region, from.data->size);
+			to_region = Internal::ResolveRegion(to_region, to_size);
+			if(from_region.size.x == 0 || from_region.size.y == 0 || to_region.size.x == 0 || to_region.size.y == 0) return;
+
+			if(!Internal::Gpu::IsGpuCopySupported()){
+				Internal::BlitOnCpu(to, to_region, from, from_region);
+				return;
+			}
+			if(to.data != nullptr && from_region.size == to_region.size && Internal::Gpu::IsImageCopySupported()){
+				Internal::Gpu::CopyImage(from.data->texture_gpu_handle, from_region.offset,
+				                         to.data->texture_gpu_handle, to_region.offset, to_region.size);
+				return;
+			}
+
+			const Internal::BlitFramebuffers& fbs = Internal::GetBlitFramebuffers();
+			Internal::Gpu::BlitFramebuffer(fbs.read, from.data->texture_gpu_handle, from_region.offset, from_region.size,
+			                               to.data == nullptr ? 0 : fbs.draw,
+			                               to.data == nullptr ? INVALID_HANDLE : to.data->texture_gpu_handle,
+			                               to_region.offset, to_region.size, linear);
+			Internal::RebindBoundFramebuffer();
+		}
+		//Same size, same place
+		inline void CopyRegion(Handle to, Handle from, TextureRegion region)
+			{ Blit(to, { region.offset, Internal::ResolveRegion(region, GetSize(from)).size }, from, region); }
+
+		//Replaces only "region" of the texture, a zero size means "up to the edge". "row_stride" is
+		//the width of the source image in pixels, so e.g. a tile can be uploaded straight out of a whole atlas,
+		//0 means the rows of "data" are packed
+		inline void SetSubData(Handle txt_handle, TextureRegion region, const uint8* data, uint32 row_stride = 0){
+#ifndef NDEBUG
+			Internal::CheckTextureValidity(txt_handle);
+#endif
+			region = Internal::ResolveRegion(region, txt_handle.data->size); //Checks the bounds too
+#ifndef NDEBUG
+			if(row_stride != 0 && row_stride < region.size.x)
+				throw std::runtime_error("The row stride given to Texture::SetSubData() is smaller than the region");
+#endif
+			if(region.size.x == 0 || region.size.y == 0) return; //An empty texture
+			Internal::FlushPendingBatches();
+			Internal::Gpu::SetTextureSubData(txt_handle.data->texture_gpu_handle, txt_handle.data->size, region.offset, region.size,
+			                                 data, row_stride == 0 ? region.size.x : row_stride);
+		}
+		inline void SetSubData(Handle txt_handle, TextureRegion region, const std::string& data, uint32 row_stride = 0)
+			{ SetSubData(txt_handle, region, (const uint8*)data.data(), row_stride); }
+
+		//Zeroes the texture on the GPU
+		inline void Clear(Handle txt_handle){
+#ifndef NDEBUG
+			Internal::CheckTextureValidity(txt_handle);
+#endif
+			Internal::FlushPendingBatches();
+			if(Internal::Gpu::IsClearTextureSupported()){
+				Internal::Gpu::ClearTexture(txt_handle.data->texture_gpu_handle, INVALID_HANDLE);
+				return;
+			}
+			Internal::Gpu::ClearTexture(txt_handle.data->texture_gpu_handle, Internal::GetTextureFramebufferHandle(txt_handle));
+			Internal::RebindBoundFramebuffer();
+		}
+		//Allocates the storage without uploading anything, e.g. for a render target. Without "clear" the contents
+		//are undefined until something is drawn or copied into them
+		inline void Allocate(Handle txt_handle, pos2du16 size, bool clear = true){
+#ifndef NDEBUG
+			Internal::CheckTextureValidity(txt_handle);
+#endif
+			Internal::FlushPendingBatches();
+			Internal::Gpu::AllocateTextureStorage(txt_handle.data->texture_gpu_handle, size);
+			Internal::OnTextureResized(txt_handle, size);
+			if(clear) Clear(txt_handle);
+		}
+		inline void Resize(Handle txt_handle, pos2du16 new_size, bool clear = true) //for usage as a framebuffer
+			{ Allocate(txt_handle, new_size, clear); }
+
+		//"to" becomes a copy of "from", modes included. It's resized only if the sizes differ
+		inline void Copy(Handle to, Handle from) {
+			const pos2du16 size = GetSize(from);
+			if(!Internal::Gpu::IsGpuCopySupported())
+				SetData(to, GetData(from), size);
+			else{
+				if(GetSize(to) != size) Allocate(to, size, false);
+				Blit(to, {}, from);
+			}
+			SetModes(to, GetFilteringMode(from), GetWrapMode(from));
+		}
+	}
+
 	inline void BindFramebuffer(Texture::Handle txt_handle){
 		Internal::bound_framebuffer_texture = txt_handle;
 		Internal::Gpu::BindFramebuffer(Internal::GetTextureFramebufferHandle(txt_handle),
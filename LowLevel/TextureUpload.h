@@ -0,0 +1,207 @@
+#pragma once
+#include <vector>
+#include <unordered_set>
+
+#include "Texture.h"
+#include "BlockLayout.h"
+#include "Gpu/Upload.h"
+
+//Streaming texture uploads through a ring of pixel buffer memory. The pixels are written into mapped buffer
+//memory and the texture is updated from it, so the driver can copy them whenever the GPU is ready instead of
+//during the call. Every upload is fenced, a part of the ring is reused only after the GPU is done with it
+namespace LLJGFX{
+	struct UploadRingStats{
+		uint64 uploads = 0;
+		uint64 uploaded_bytes = 0;
+		uint64 stalls = 0; //Uploads that had to wait for the GPU, the ring is too small for the rate of the uploads
+	};
+
+	namespace Internal{
+		constexpr size_t UPLOAD_RING_ALIGNMENT = 16;
+
+		struct UploadSegment{
+			size_t offset;
+			size_t size;
+			GLsync fence;
+		};
+
+		struct UploadRingDataHolder{
+			HandleType gpu_handle = INVALID_HANDLE;
+			size_t capacity = 0;
+			size_t head = 0;
+			std::vector<UploadSegment> in_flight; //Oldest first
+
+			//Between Begin() and End()
+			uint8* mapped = nullptr;
+			size_t mapped_offset = 0;
+			Texture::Handle target = { nullptr };
+			TextureRegion target_region;
+
+			UploadRingStats stats;
+		};
+
+		std::unordered_set<UploadRingDataHolder*> all_upload_ring_handles;
+
+		void CheckUploadRingValidity(UploadRingDataHolder* data){
+			if(!all_upload_ring_handles.contains(data))
+				throw std::runtime_error(data == nullptr ?
+				                         "Non-existent upload ring was requested using uninitialized handle" :
+				                         "Deleted upload ring was requested");
+		}
+
+		//The rings made before are moved from plain memory into pixel buffers
+		void InitializeTextureUploads(){
+			for(UploadRingDataHolder* i : all_upload_ring_handles)
+				Gpu::DeletePixelBuffer(i->gpu_handle);
+
+			Gpu::MakePixelBuffer = Gpu::Opengl33::MakePixelBuffer;
+			Gpu::DeletePixelBuffer = Gpu::Opengl33::DeletePixelBuffer;
+			Gpu::MapPixelBuffer = Gpu::Opengl33::MapPixelBuffer;
+			Gpu::UploadFromPixelBuffer = Gpu::Opengl33::UploadFromPixelBuffer;
+			Gpu::MakeReadbackBuffer = Gpu::Opengl33::MakeReadbackBuffer;
+			Gpu::ReadPixelsToBuffer = Gpu::Opengl33::ReadPixelsToBuffer;
+			Gpu::ReadBufferPixels = Gpu::Opengl33::ReadBufferPixels;
+			Gpu::InsertFence = Gpu::Opengl33::InsertFence;
+			Gpu::IsFenceSignaled = Gpu::Opengl33::IsFenceSignaled;
+			Gpu::FlushCommands = Gpu::Opengl33::FlushCommands;
+			Gpu::WaitFence = Gpu::Opengl33::WaitFence;
+			Gpu::DeleteFence = Gpu::Opengl33::DeleteFence;
+
+			for(UploadRingDataHolder* i : all_upload_ring_handles){
+				i->gpu_handle = Gpu::MakePixelBuffer(i->capacity);
+				i->in_flight.clear(); //Their fences were never real
+				i->head = 0;
+			}
+		}
+
+		//Drops the segments, that the GPU is done with
+		inline void RetireUploadSegments(UploadRingDataHolder& dat){
+			size_t retired = 0;
+			while(retired < dat.in_flight.size() && Gpu::IsFenceSignaled(dat.in_flight[retired].fence))
+				Gpu::DeleteFence(dat.in_flight[retired++].fence);
+			dat.in_flight.erase(dat.in_flight.begin(), dat.in_flight.begin() + retired);
+		}
+
+		//Finds room for "size" bytes after the head(or at the start of the ring) and waits for the uploads,
+		//that still read from there
+		inline size_t ReserveUploadRange(UploadRingDataHolder& dat, size_t size){
+			RetireUploadSegments(dat);
+
+			size_t offset = RoundUp(dat.head, UPLOAD_RING_ALIGNMENT);
+			if(offset + size > dat.capacity) offset = 0;
+
+			bool stalled = false;
+			for(size_t i = 0; i < dat.in_flight.size();){
+				const UploadSegment& c_seg = dat.in_flight[i];
+				if(c_seg.offset < offset + size && offset < c_seg.offset + c_seg.size){
+					Gpu::WaitFence(c_seg.fence);
+					Gpu::DeleteFence(c_seg.fence);
+					dat.in_flight.erase(dat.in_flight.begin() + i);
+					stalled = true;
+				}
+				else i++;
+			}
+			if(stalled) dat.stats.stalls++;
+
+			dat.head = offset + size;
+			return offset;
+		}
+	}
+
+	namespace UploadRing{
+		struct Handle{
+			Internal::UploadRingDataHolder* data = nullptr;
+		};
+
+		inline bool IsValid(Handle handle) { return Internal::all_upload_ring_handles.contains(handle.data); }
+
+		//A few frames worth of uploads is enough to never wait. Before the initialization the uploads go straight
+		//into the CPU copies of the textures
+		inline Handle Make(size_t capacity){
+			Handle handle = { new Internal::UploadRingDataHolder };
+			Internal::all_upload_ring_handles.insert(handle.data);
+
+			handle.data->capacity = capacity;
+			handle.data->gpu_handle = Internal::Gpu::MakePixelBuffer(capacity);
+			return handle;
+		}
+		//The uploads in flight still finish, a deleted buffer lives until the GPU is done with it
+		inline void Delete(Handle ring_handle){
+			if(ring_handle.data == nullptr) return;
+#ifndef NDEBUG
+			Internal::CheckUploadRingValidity(ring_handle.data);
+#endif
+			Internal::UploadRingDataHolder& dat = *ring_handle.data;
+			for(const Internal::UploadSegment& i : dat.in_flight)
+				Internal::Gpu::DeleteFence(i.fence);
+			Internal::Gpu::DeletePixelBuffer(dat.gpu_handle);
+
+			Internal::all_upload_ring_handles.erase(ring_handle.data);
+			delete ring_handle.data;
+		}
+
+		//Returns the memory for the pixels of "region"(packed rows, 4 bytes per pixel), they are sent with End().
+		//Nothing else may be uploaded through the ring in between
+		inline uint8* Begin(Handle ring_handle, Texture::Handle txt_handle, TextureRegion region){
+#ifndef NDEBUG
+			Internal::CheckUploadRingValidity(ring_handle.data);
+			Internal::CheckTextureValidity(txt_handle);
+			if(ring_handle.data->mapped != nullptr)
+				throw std::runtime_error("UploadRing::Begin() was called again before End()");
+#endif
+			Internal::UploadRingDataHolder& dat = *ring_handle.data;
+			region = Internal::ResolveRegion(region, txt_handle.data->size);
+			const size_t size = (size_t)region.size.x * region.size.y * JGFX::PIXEL_BINARY_SIZE;
+#ifndef NDEBUG
+			if(size > dat.capacity)
+				throw std::runtime_error("The upload is larger than the whole upload ring");
+#endif
+			dat.mapped_offset = Internal::ReserveUploadRange(dat, size);
+			dat.mapped = Internal::Gpu::MapPixelBuffer(dat.gpu_handle, dat.mapped_offset, size);
+#ifndef NDEBUG
+			if(dat.mapped == nullptr)
+				throw std::runtime_error("Failed to map the upload ring");
+#endif
+			dat.target = txt_handle;
+			dat.target_region = region;
+
+			dat.stats.uploads++;
+			dat.stats.uploaded_bytes += size;
+			return dat.mapped;
+		}
+		inline void End(Handle ring_handle){
+#ifndef NDEBUG
+			Internal::CheckUploadRingValidity(ring_handle.data);
+			if(ring_handle.data->mapped == nullptr)
+				throw std::runtime_error("UploadRing::End() was called without Begin()");
+			Internal::CheckTextureValidity(ring_handle.data->target);
+#endif
+			Internal::UploadRingDataHolder& dat = *ring_handle.data;
+			const TextureRegion& region = dat.target_region;
+			Internal::FlushPendingBatches(); //One of them could sample the texture
+			Internal::Gpu::UploadFromPixelBuffer(dat.gpu_handle, dat.mapped_offset, dat.target.data->texture_gpu_handle,
+			                                     dat.target.data->size, region.offset, region.size);
+			dat.in_flight.push_back({ dat.mapped_offset, (size_t)region.size.x * region.size.y * JGFX::PIXEL_BINARY_SIZE,
+			                          Internal::Gpu::InsertFence() });
+			dat.mapped = nullptr;
+			dat.target = { nullptr };
+		}
+
+		//Begin() and End() with a copy in between. "row_stride" is the same as in Texture::SetSubData()
+		inline void Upload(Handle ring_handle, Texture::Handle txt_handle, TextureRegion region, const uint8* data,
+		                   uint32 row_stride = 0){
+			region = Internal::ResolveRegion(region, Texture::GetSize(txt_handle));
+			uint8* dest = Begin(ring_handle, txt_handle, region);
+			const size_t row_size = (size_t)region.size.x * JGFX::PIXEL_BINARY_SIZE;
+			const size_t src_row_size = row_stride == 0 ? row_size : (size_t)row_stride * JGFX::PIXEL_BINARY_SIZE;
+			if(src_row_size == row_size)
+				memcpy(dest, data, row_size * region.size.y);
+			else for(uint32 y = 0; y < region.size.y; y++)
+				memcpy(dest + y * row_size, data + y * src_row_size, row_size);
+			End(ring_handle);
+		}
+
+		inline size_t GetCapacity(Handle ring_handle) { return ring_handle.data->capacity; }
+		inline UploadRingStats GetStats(Handle ring_handle) { return ring_handle.data->stats; }
+	}
+}
@@ -0,0 +1,162 @@
+#pragma once
+#include <array>
+#include <unordered_set>
+
+#include "Shader.h"
+#include "../Mesh.hpp"
+#include "Gpu/TransformFeedback.h"
+
+//The outputs of a vertex shader written into VBuffs, so a simulation can run on the GPU without a round trip to the
+//CPU. The program has to be compiled with ShaderProgram::CompileWithFeedback()
+namespace LLJGFX{
+	namespace Internal{
+		constexpr uint32 FEEDBACK_BUFFER_COUNT = 4; //The minimum GL 3.3 guarantees for separate attributes
+
+		struct FeedbackPairDataHolder{
+			//Every buffer has its own VRef to be read through, a buffer can't be captured from and into at once
+			VBuff::Handle buffers[2];
+			VRef::Handle sources[2];
+			uint32 front = 0;
+			uint32 vertex_count = 0;
+		};
+
+		std::unordered_set<FeedbackPairDataHolder*> all_feedback_pair_handles;
+
+		void CheckFeedbackPairValidity(FeedbackPairDataHolder* data){
+			if(!all_feedback_pair_handles.contains(data))
+				throw std::runtime_error(data == nullptr ?
+				                         "Non-existent feedback pair was requested using uninitialized handle" :
+				                         "Deleted feedback pair was requested");
+		}
+
+		void InitializeTransformFeedback(){
+			Gpu::CaptureVertices = Gpu::Opengl33::CaptureVertices;
+		}
+	}
+
+	namespace TransformFeedback{
+		//Runs the vertices of "source" through the program and writes its varyings into "targets": one buffer for
+		//interleaved varyings, one per varying otherwise. Async programs are waited for, like with a dispatch.
+		//The CPU copies of the targets(VBuff::GetData()) don't see the captured data
+		inline void Capture(ShaderProgram::Handle prg_handle, VRef::Handle source, const std::vector<VBuff::Handle>& targets,
+		                    uint32 vertex_count, uint32 first_vertex = 0, bool discard_rasterizer = true){
+#ifndef NDEBUG
+			Internal::CheckProgramValidity(prg_handle);
+			if(!ShaderProgram::HasFeedback(prg_handle))
+				throw std::runtime_error("Only programs compiled with CompileWithFeedback() can capture vertices");
+
+			const Internal::GpuProgram& gp = *prg_handle.data->gpu;
+			const size_t expected = gp.feedback_interleaved ? 1 : gp.feedback_varyings.size();
+			if(targets.size() != expected)
+				throw std::runtime_error("Transform feedback needs " + std::to_string(expected) + " target buffer(s), " +
+				                         std::to_string(targets.size()) + " were given");
+			if(expected > Internal::FEEDBACK_BUFFER_COUNT)
+				throw std::runtime_error("Too many separate varyings for transform feedback");
+
+			Internal::find_vr_data(source);
+			for(const VBuff::Handle i : targets){
+				const Internal::VBuffDataHolder& vb_dat = Internal::find_vb_data(i);
+				if(vb_dat.layout.size() && vertex_count * vb_dat.layout.CalculateStride() > Internal::GetVbBinarySize(vb_dat))
+					throw std::runtime_error("The captured vertices don't fit into the target buffer");
+			}
+#endif
+			Internal::ProgramDataHolder& dat = *prg_handle.data;
+			Internal::FinishProgram(*dat.gpu);
+			Internal::Gpu::State::UseProgram(dat.gpu->gpu_handle);
+			Internal::CommitUniforms(dat);
+			Internal::Gpu::State::BindVertexArray(source.handle);
+
+			//Checked in release builds too, it guards the fixed array below
+			if(targets.size() > Internal::FEEDBACK_BUFFER_COUNT)
+				throw std::runtime_error("Transform feedback can't write into more than 4 buffers");
+			std::array<HandleType, Internal::FEEDBACK_BUFFER_COUNT> buffers;
+			for(size_t i = 0; i < targets.size(); i++)
+				buffers[i] = targets[i].handle;
+			Internal::Gpu::CaptureVertices(buffers.data(), (uint32)targets.size(), first_vertex, vertex_count, discard_rasterizer);
+		}
+	}
+
+	//Two buffers with the same layout, every step reads the front one and writes the back one, then swaps them
+	namespace FeedbackPair{
+		struct Handle{
+			Internal::FeedbackPairDataHolder* data = nullptr;
+		};
+
+		inline bool IsValid(Handle handle) { return Internal::all_feedback_pair_handles.contains(handle.data); }
+
+		//Can't be made before the initialization. "data" is the initial state of the front buffer
+		template<typename T> inline Handle Make(const T* data, size_t size, const JGFX::VertexLayout& layout){
+			Handle handle = { new Internal::FeedbackPairDataHolder };
+			Internal::all_feedback_pair_handles.insert(handle.data);
+
+			Internal::FeedbackPairDataHolder& dat = *handle.data;
+			dat.buffers[0] = VBuff::Make(data, size, layout);
+			dat.buffers[1] = VBuff::Make();
+			VBuff::SetLayout(dat.buffers[1], layout);
+			dat.vertex_count = (uint32)VBuff::GetSize(dat.buffers[0]);
+
+			//The GPU writes both from now on, so they keep only the size instead of a CPU copy, that would go stale
+			const size_t byte_size = VBuff::GetBinarySize(dat.buffers[0]);
+			for(uint32 i = 0; i < 2; i++){
+				Internal::VBuffDataHolder& vb_dat = Internal::find_vb_data(dat.buffers[i]);
+				vb_dat.binary = {};
+				vb_dat.is_gpu_only = true;
+				vb_dat.gpu_only_size = byte_size;
+			}
+			VBuff::Resize(dat.buffers[1], byte_size); //Allocated without uploading anything
+
+			for(uint32 i = 0; i < 2; i++){
+				dat.sources[i] = VRef::Make();
+				VRef::AttachVBuff(dat.sources[i], dat.buffers[i]);
+			}
+			return handle;
+		}
+		template<typename T> inline Handle Make(const std::vector<T>& data, const JGFX::VertexLayout& layout)
+			{ return Make(data.data(), data.size(), layout); }
+
+		inline void Delete(Handle pair_handle){
+			if(pair_handle.data == nullptr) return;
+#ifndef NDEBUG
+			Internal::CheckFeedbackPairValidity(pair_handle.data);
+#endif
+			for(uint32 i = 0; i < 2; i++){
+				VRef::Delete(pair_handle.data->sources[i]);
+				VBuff::Delete(pair_handle.data->buffers[i]); //Detaches it from the VRefs of the user too
+			}
+			Internal::all_feedback_pair_handles.erase(pair_handle.data);
+			delete pair_handle.data;
+		}
+
+		//The VRefs, that have the front buffer attached(see Attach()), are moved over to the new front one
+		inline void Step(Handle pair_handle, ShaderProgram::Handle prg_handle, bool discard_rasterizer = true){
+#ifndef NDEBUG
+			Internal::CheckFeedbackPairValidity(pair_handle.data);
+#endif
+			Internal::FeedbackPairDataHolder& dat = *pair_handle.data;
+			const uint32 back = 1 - dat.front;
+			TransformFeedback::Capture(prg_handle, dat.sources[dat.front], { dat.buffers[back] }, dat.vertex_count, 0,
+			                           discard_rasterizer);
+
+			const std::unordered_set<VRef::Handle> attached = Internal::find_vb_data(dat.buffers[dat.front]).bound_to;
+			for(const VRef::Handle i : attached){
+				if(i == dat.sources[dat.front]) continue;
+				VRef::DetachVBuff(i, dat.buffers[dat.front]);
+				VRef::AttachVBuff(i, dat.buffers[back]);
+			}
+			dat.front = back;
+		}
+
+		//Attaches the front buffer to a VRef, e.g. as per-instance data of a mesh. It follows the front buffer
+		//until it's detached with VRef::DetachVBuff(vref, GetFront())
+		inline void Attach(Handle pair_handle, VRef::Handle vr_handle){
+#ifndef NDEBUG
+			Internal::CheckFeedbackPairValidity(pair_handle.data);
+#endif
+			VRef::AttachVBuff(vr_handle, pair_handle.data->buffers[pair_handle.data->front]);
+		}
+
+		//Holds the result of the last step. It has no CPU copy, VBuff::GetData() reads it back from the GPU
+		inline VBuff::Handle GetFront(Handle pair_handle) { return pair_handle.data->buffers[pair_handle.data->front]; }
+		inline uint32 GetVertexCount(Handle pair_handle) { return pair_handle.data->vertex_count; }
+	}
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <unordered_set>
+
+#include "Shader.h"
+#include "BlockLayout.h"
+#include "Gpu/UniformBuffer.h"
+
+//Data shared by every program, that declares a uniform block with the same name.
+//Each buffer gets its own binding point, programs are wired to it when they link(or when the buffer is made)
+namespace LLJGFX{
+	namespace Internal{
+		struct UboDataHolder{
+			HandleType gpu_handle = INVALID_HANDLE;
+			std::string block_name;
+			uint32 binding_point = 0;
+			std::vector<uint8> data; //CPU copy, used to fill the buffer after the initialization
+		};
+
+		std::unordered_set<UboDataHolder*> all_ubo_handles;
+		std::vector<uint32> free_ubo_binding_points;
+		uint32 next_ubo_binding_point = 0;
+		//Nothing is ever bound here. Blocks of deleted buffers are moved to it, so their programs don't read
+		//the buffer, that gets the recycled binding point next
+		constexpr uint32 DETACHED_UBO_BINDING_POINT = Gpu::State::UNIFORM_BUFFER_BINDING_COUNT - 1;
+
+		void CheckUboValidity(UboDataHolder* data){
+			if(!all_ubo_handles.contains(data))
+				throw std::runtime_error(data == nullptr ?
+				                         "Non-existent uniform buffer was requested using uninitialized handle" :
+				                         "Deleted uniform buffer was requested");
+		}
+
+		void InitializeUniformBuffers(){
+			Gpu::MakeUniformBuffer = Gpu::Opengl33::MakeUniformBuffer;
+			Gpu::DeleteUniformBuffer = Gpu::Opengl33::DeleteUniformBuffer;
+			Gpu::SetUniformBufferData = Gpu::Opengl33::SetUniformBufferData;
+			Gpu::BindUniformBuffer = Gpu::Opengl33::BindUniformBuffer;
+
+			for(UboDataHolder* i : all_ubo_handles){
+				i->gpu_handle = Gpu::MakeUniformBuffer(i->data.size());
+				Gpu::SetUniformBufferData(i->gpu_handle, i->data.size(), 0, i->data.data(), i->data.size());
+				Gpu::BindUniformBuffer(i->binding_point, i->gpu_handle);
+			}
+		}
+	}
+
+	namespace UniformBuffer{
+		struct Handle{
+			Internal::UboDataHolder* data = nullptr;
+		};
+
+		inline bool IsValid(Handle handle) { return Internal::all_ubo_handles.contains(handle.data); }
+
+		//"size" is usually Std140Layout<...>::size
+		inline Handle Make(const std::string& block_name, size_t size){
+			if(Internal::uniform_block_bindings.contains(block_name))
+				throw std::runtime_error("Uniform block \"" + block_name + "\" already has a buffer");
+
+			uint32 binding_point = Internal::next_ubo_binding_point;
+			if(!Internal::free_ubo_binding_points.empty()){
+				binding_point = Internal::free_ubo_binding_points.back();
+				Internal::free_ubo_binding_points.pop_back();
+			}
+			else if(Internal::next_ubo_binding_point == Internal::DETACHED_UBO_BINDING_POINT)
+				throw std::runtime_error("Out of uniform buffer binding points");
+			else Internal::next_ubo_binding_point++;
+
+			Handle handle = { new Internal::UboDataHolder{} };
+			Internal::all_ubo_handles.insert(handle.data);
+			Internal::UboDataHolder& dat = *handle.data;
+
+			dat.block_name = block_name;
+			dat.binding_point = binding_point;
+			dat.data.resize(size);
+			dat.gpu_handle = Internal::Gpu::MakeUniformBuffer(size);
+			Internal::Gpu::BindUniformBuffer(binding_point, dat.gpu_handle);
+
+			//Programs, that link later, are wired in RebuildUniformTable()
+			Internal::uniform_block_bindings.insert({block_name, binding_point});
+			for(Internal::GpuProgram* i : Internal::all_gpu_programs)
+				if(!i->is_pending) Internal::Gpu::BindUniformBlock(i->gpu_handle, block_name, binding_point);
+			return handle;
+		}
+		inline void Delete(Handle ubo_handle){
+			if(ubo_handle.data == nullptr) return;
+#ifndef NDEBUG
+			Internal::CheckUboValidity(ubo_handle.data);
+#endif
+			Internal::UboDataHolder& dat = *ubo_handle.data;
+			Internal::Gpu::DeleteUniformBuffer(dat.gpu_handle);
+			Internal::uniform_block_bindings.erase(dat.block_name);
+			for(Internal::GpuProgram* i : Internal::all_gpu_programs)
+				if(!i->is_pending) Internal::Gpu::BindUniformBlock(i->gpu_handle, dat.block_name, Internal::DETACHED_UBO_BINDING_POINT);
+			Internal::free_ubo_binding_points.push_back(dat.binding_point);
+
+			Internal::all_ubo_handles.erase(ubo_handle.data);
+			delete ubo_handle.data;
+		}
+
+		//Also binds the buffer to its binding point in the current context
+		inline void SetData(Handle ubo_handle, const void* data, size_t size, size_t offset = 0){
+#ifndef NDEBUG
+			Internal::CheckUboValidity(ubo_handle.data);
+			if(offset + size > ubo_handle.data->data.size())
+				throw std::runtime_error("The data is out of the uniform buffer bounds");
+#endif
+			Internal::UboDataHolder& dat = *ubo_handle.data;
+			memcpy(dat.data.data() + offset, data, size);
+			Internal::Gpu::SetUniformBufferData(dat.gpu_handle, dat.data.size(), offset, data, size);
+			Internal::Gpu::BindUniformBuffer(dat.binding_point, dat.gpu_handle);
+		}
+		//Packs every member of the block and uploads it at once
+		template<typename Layout, typename... Ts> inline void SetBlock(Handle ubo_handle, const Ts&... values){
+			std::array<uint8, Layout::size> packed = {};
+			Layout::Pack(packed.data(), values...);
+			SetData(ubo_handle, packed.data(), packed.size());
+		}
+		template<typename Layout, size_t I> inline void SetMember(Handle ubo_handle, const typename Layout::template MemberType<I>& value){
+			std::array<uint8, Layout::sizes[I]> packed = {};
+			Layout::template PackMember<I>(packed.data(), value);
+			SetData(ubo_handle, packed.data(), packed.size(), Layout::offsets[I]);
+		}
+
+		inline uint32 GetBindingPoint(Handle ubo_handle) { return ubo_handle.data->binding_point; }
+		inline size_t GetSize(Handle ubo_handle) { return ubo_handle.data->data.size(); }
+		inline const std::string& GetBlockName(Handle ubo_handle) { return ubo_handle.data->block_name; }
+	}
+}
@@ -6,6 +6,7 @@
 #include "Common.h"
 #include "Texture.h"
 #include "Gpu/Draw.h"
+#include "FrameArena.h"
 
 bool InitFunc();
 //void DestroyFunc();
@@ -189,12 +190,7 @@ namespace LLJGFX{
 		}
 #endif
 
-		inline pos2du16 GetSize(Handle win_handle){
-			int32 x_adapter;
-			int32 y_adapter;
-			glfwGetWindowSize(Internal::get_ro_win_data(win_handle).win, &x_adapter, &y_adapter);
-			return { x_adapter, y_adapter };
-		}
+		inline pos2du16 GetSize(Handle win_handle) { return Internal::GetWindowSize(Internal::get_ro_win_data(win_handle).win); }
 		inline pos2d16 GetPos(Handle win_handle){
 			int32 x_adapter;
 			int32 y_adapter;
@@ -240,7 +236,7 @@ namespace LLJGFX{
 
 
 			if(Internal::all_window_handles.empty()){
-				glfwMakeContextCurrent(dat.win);
+				Internal::Gpu::State::MakeContextCurrent(dat.win);
 				Internal::curr_context = &dat;
 				InitFunc();
 			}
@@ -248,11 +244,7 @@ namespace LLJGFX{
 			Internal::all_window_handles.insert(handle.data);
 
 			SetIcon(handle, icon);
-
-			for(int i = 0; i < Opt::STENCIL_TEST; i++){
-				if(Internal::opt_modes[i]) Internal::Gpu::Enable((Opt::OptFtr)i);
-				else Internal::Gpu::Disable((Opt::OptFtr)i);
-			}
+			//The Opt toggles reach the new context lazily, with its first draw
 
 			return handle;
 		}
@@ -263,9 +255,14 @@ namespace LLJGFX{
 			Internal::WindowDataHolder& dat = *win_handle.data;
 
 			glfwDestroyWindow(dat.win);
+			if(Internal::Gpu::State::current_window == dat.win){ //GLFW detaches the context of a destroyed window
+				Internal::Gpu::State::current_window = nullptr;
+				Internal::Gpu::State::Invalidate();
+			}
 
 			for(Internal::TxtDataHolder* i : win_handle.data->local_framebuffers)
 				i->context_framebuffers.erase(win_handle.data);
+			Internal::blit_framebuffers.erase(win_handle.data); //Destroyed with the context
 
 			if(Internal::curr_context == win_handle.data) Internal::curr_context = nullptr;
 
@@ -276,14 +273,26 @@ namespace LLJGFX{
 		}
 	}
 
+	namespace Internal{
+		void PresentNow(){
+			for(WindowDataHolder* i : all_window_handles)
+				glfwSwapBuffers(i->win);
+
+			if(bound_framebuffer_texture.data == nullptr)
+				Gpu::SetViewportSize(Window::GetSize({curr_context}));
+
+			Gpu::State::EndFrame();
+		}
+		//Replaced while the render thread is running(see RenderThread.h)
+		void(*Present)() = PresentNow;
+	}
+
 	inline void NewFrame() {
 		glfwPollEvents();
 
-		for(Internal::WindowDataHolder* i : Internal::all_window_handles)
-			glfwSwapBuffers(i->win);
-
-		if(Internal::bound_framebuffer_texture.data == nullptr)
-			Internal::Gpu::SetViewportSize(Window::GetSize({Internal::curr_context}));
+		Internal::Present();
+		FrameArena::Reset();
+		Internal::EndFrameAllocations();
 
 		const fl64 currentFrame = glfwGetTime();
 		Internal::delta_time = currentFrame - Internal::last_frame;
@@ -297,7 +306,7 @@ namespace LLJGFX{
 	inline void BindFramebuffer(Window::Handle win_handle){
 		Internal::CheckWindowValidity(win_handle);
 
-		glfwMakeContextCurrent(win_handle.data->win);
+		Internal::Gpu::State::MakeContextCurrent(win_handle.data->win);
 		Internal::Gpu::BindFramebuffer(0, Window::GetSize(win_handle));
 		Internal::curr_context = win_handle.data;
 		Internal::bound_framebuffer_texture = { nullptr };
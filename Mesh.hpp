@@ -10,6 +10,7 @@
 
 #include "pos2d.h"
 #include "LowLevel/Common.h"
+#include "LowLevel/Gpu/State.h"
 
 namespace JGFX {
 	enum class AttribType {
@@ -201,6 +202,9 @@ namespace LLJGFX {
 			//size_t associated_type_hash = 0; //hash of the type, that is associated with the current layout.
 			//Used to prevent assignment of data with an invalid type to a vertex buffer
 			std::vector<uint8> binary;
+			//Buffers written by the GPU(storage buffers) keep no CPU copy, "binary" stays empty then
+			bool is_gpu_only = false;
+			size_t gpu_only_size = 0;
 		};
 		std::unordered_map<VBuff::Handle, VBuffDataHolder> vbuff_data;
 		inline VBuffDataHolder& find_vb_data(VBuff::Handle vbuff_handle) {
@@ -210,6 +214,7 @@ namespace LLJGFX {
 #endif
 			return vbuff_data.find(vbuff_handle)->second;
 		}
+		inline size_t GetVbBinarySize(const VBuffDataHolder& dat) { return dat.is_gpu_only ? dat.gpu_only_size : dat.binary.size(); }
 
 		struct VRefDataHolder{
 			//bool is_initialized = false;
@@ -228,23 +233,22 @@ namespace LLJGFX {
 
 		inline void UnbindBuffers(){
 			//glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			Gpu::State::BindArrayBuffer(0);
 		}
 		inline void UnbindVertexLayout(VRef::Handle vao, VBuff::Handle vbo){
 			UnbindBuffers();
-			glBindVertexArray(vao.handle);
-			glBindBuffer(GL_ARRAY_BUFFER, vbo.handle);
+			Gpu::State::BindVertexArray(vao.handle);
+			Gpu::State::BindArrayBuffer(vbo.handle);
 
 			const VBuffDataHolder& vb_dat = find_vb_data(vbo);
 
 			for(const std::pair<HandleType, JGFX::RestrictedVertexAttribute> i : vb_dat.layout.map())
 				{ glVertexAttribDivisor(i.first, 0); glDisableVertexAttribArray(i.first); }
-			glBindVertexArray(0);
 		}
 		void BindVertexLayout(VRef::Handle vao, VBuff::Handle vbo, const JGFX::VertexLayout& layout){
 			Internal::UnbindBuffers();
-			glBindVertexArray(vao.handle);
-			glBindBuffer(GL_ARRAY_BUFFER, vbo.handle);
+			Gpu::State::BindVertexArray(vao.handle);
+			Gpu::State::BindArrayBuffer(vbo.handle);
 
 			size_t offset = 0;
 			const size_t stride = layout.CalculateStride();
@@ -261,16 +265,16 @@ namespace LLJGFX {
 
 				offset += JGFX::attrib_size_table.find(elem.second.type)->second * elem.second.amount;
 			}
-			glBindVertexArray(0);
 		}
 	}
 
 	namespace VBuff{
 		template<typename T> inline void ForceSetData(Handle vbuff_handle, const T* data, size_t size){
 			Internal::VBuffDataHolder& dat = Internal::find_vb_data(vbuff_handle);
-			glBindBuffer(GL_ARRAY_BUFFER, vbuff_handle.handle);
+			Internal::Gpu::State::BindArrayBuffer(vbuff_handle.handle);
 			glBufferData(GL_ARRAY_BUFFER, sizeof(T) * size, data, GL_STATIC_DRAW);
 
+			dat.is_gpu_only = false;
 			dat.binary.resize(size * sizeof(T));
 			memcpy(dat.binary.data(), data, size * sizeof(T));
 		}
@@ -289,16 +293,59 @@ namespace LLJGFX {
 		template<typename T> inline void SetData(Handle vbuff_handle, const std::vector<T>& data)
 			{ SetData(vbuff_handle, data.data(), data.size()); }
 
+		//Changes a part of the buffer without re-specifying the whole storage
+		inline void SetSubData(Handle vbuff_handle, size_t byte_offset, const void* data, size_t byte_size){
+			Internal::VBuffDataHolder& dat = Internal::find_vb_data(vbuff_handle);
+#ifndef NDEBUG
+			if(byte_offset + byte_size > Internal::GetVbBinarySize(dat))
+				throw std::runtime_error("The data given to VertexBuffer::SetSubData() is out of the buffer bounds");
+#endif
+			Internal::Gpu::State::BindArrayBuffer(vbuff_handle.handle);
+			glBufferSubData(GL_ARRAY_BUFFER, byte_offset, byte_size, data);
+			if(!dat.is_gpu_only) memcpy(dat.binary.data() + byte_offset, data, byte_size);
+		}
+		//For data that is rewritten every frame. The old storage is orphaned, so the driver doesn't have to wait
+		//for the draws that are still reading it
+		inline void StreamData(Handle vbuff_handle, const void* data, size_t byte_size){
+			Internal::VBuffDataHolder& dat = Internal::find_vb_data(vbuff_handle);
+			Internal::Gpu::State::BindArrayBuffer(vbuff_handle.handle);
+			glBufferData(GL_ARRAY_BUFFER, byte_size, nullptr, GL_STREAM_DRAW);
+			glBufferSubData(GL_ARRAY_BUFFER, 0, byte_size, data);
+
+			dat.is_gpu_only = false;
+			dat.binary.resize(byte_size);
+			memcpy(dat.binary.data(), data, byte_size);
+		}
+		//Reallocates the storage, the old contents are kept(and the new part is zeroed).
+		//A buffer without a CPU copy loses its contents
+		inline void Resize(Handle vbuff_handle, size_t byte_size){
+			Internal::VBuffDataHolder& dat = Internal::find_vb_data(vbuff_handle);
+			if(dat.is_gpu_only){
+				dat.gpu_only_size = byte_size;
+				Internal::Gpu::State::BindArrayBuffer(vbuff_handle.handle);
+				glBufferData(GL_ARRAY_BUFFER, byte_size, nullptr, GL_DYNAMIC_COPY);
+				return;
+			}
+			dat.binary.resize(byte_size);
+			Internal::Gpu::State::BindArrayBuffer(vbuff_handle.handle);
+			glBufferData(GL_ARRAY_BUFFER, byte_size, dat.binary.data(), GL_STATIC_DRAW);
+		}
+
 		inline size_t GetSize(Handle vbuff_handle){
 			Internal::VBuffDataHolder& dat = Internal::find_vb_data(vbuff_handle);
-			return dat.binary.size() / dat.layout.CalculateStride();
+			return Internal::GetVbBinarySize(dat) / dat.layout.CalculateStride();
 		}
 		inline size_t GetBinarySize(Handle vbuff_handle)
-			{ return Internal::find_vb_data(vbuff_handle).binary.size(); }
+			{ return Internal::GetVbBinarySize(Internal::find_vb_data(vbuff_handle)); }
 		template<typename T> inline void GetData(Handle vbuff_handle, T* dest){
 			Internal::VBuffDataHolder& dat = Internal::find_vb_data(vbuff_handle);
 			//if(typeid(T).hash_code() != dat.associated_type_hash && dat.associated_type_hash != 0)
 			//	throw std::runtime_error("Trying to assign data with invalid type to a vertex buffer(make sure it matches what was described in the vertex layout)");
+			if(dat.is_gpu_only){ //Read back, this stalls until the GPU is done with the buffer
+				Internal::Gpu::State::BindArrayBuffer(vbuff_handle.handle);
+				glGetBufferSubData(GL_ARRAY_BUFFER, 0, dat.gpu_only_size, dest);
+				return;
+			}
 			memcpy(dest, dat.binary.data(), dat.binary.size());
 		}
 		template<typename T> inline std::vector<T> GetData(Handle vbuff_handle){
@@ -349,6 +396,7 @@ namespace LLJGFX {
 				}
 
 				glDeleteBuffers(1, &vbuff_handle.handle);
+				Internal::Gpu::State::ForgetBuffer(vbuff_handle.handle);
 				Internal::vbuff_data.erase(vbuff_handle);
 
 #ifdef JGFX_LL_DEBUG_OBJECTS_TRACKING
@@ -405,15 +453,35 @@ namespace LLJGFX {
 
 		inline void SetIndexingData(Handle vref_handle, const HandleType* data, size_t size) {
 			Internal::VRefDataHolder& dat = Internal::find_vr_data(vref_handle);
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, dat.ibuff_handle);
+			//The element buffer binding belongs to the VAO, so bind the own one instead of whatever is left bound
+			Internal::Gpu::State::BindVertexArray(vref_handle.handle);
+			Internal::Gpu::State::BindElementBuffer(dat.ibuff_handle);
 			glBufferData(GL_ELEMENT_ARRAY_BUFFER, size * sizeof(HandleType), data, GL_STATIC_DRAW);
 
 			dat.ibuff_data.resize(size);
 			memcpy(dat.ibuff_data.data(), data, size * sizeof(HandleType));
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 		}
 		inline void SetIndexingData(Handle vref_handle, const std::vector<HandleType>& data)
 			{ SetIndexingData(vref_handle, data.data(), data.size()); }
+		inline void SetIndexingSubData(Handle vref_handle, size_t offset, const HandleType* data, size_t size) {
+			Internal::VRefDataHolder& dat = Internal::find_vr_data(vref_handle);
+#ifndef NDEBUG
+			if(offset + size > dat.ibuff_data.size())
+				throw std::runtime_error("The data given to VertexReferencer::SetIndexingSubData() is out of the buffer bounds");
+#endif
+			Internal::Gpu::State::BindVertexArray(vref_handle.handle);
+			Internal::Gpu::State::BindElementBuffer(dat.ibuff_handle);
+			glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset * sizeof(HandleType), size * sizeof(HandleType), data);
+			memcpy(dat.ibuff_data.data() + offset, data, size * sizeof(HandleType));
+		}
+		//Same as VBuff::Resize(), but for the indexing data
+		inline void ResizeIndexingData(Handle vref_handle, size_t size) {
+			Internal::VRefDataHolder& dat = Internal::find_vr_data(vref_handle);
+			dat.ibuff_data.resize(size);
+			Internal::Gpu::State::BindVertexArray(vref_handle.handle);
+			Internal::Gpu::State::BindElementBuffer(dat.ibuff_handle);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, size * sizeof(HandleType), dat.ibuff_data.data(), GL_STATIC_DRAW);
+		}
 		inline std::vector<HandleType> GetIndexingData(Handle vref_handle)
 			{ return Internal::find_vr_data(vref_handle).ibuff_data; }
 
@@ -424,11 +492,8 @@ namespace LLJGFX {
 			Internal::VRefDataHolder& dat = Internal::vref_data[handle];
 			glGenBuffers(1, &dat.ibuff_handle);
 
-			glBindVertexArray(handle.handle);
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, dat.ibuff_handle);
-
-			glBindVertexArray(0);
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+			Internal::Gpu::State::BindVertexArray(handle.handle);
+			Internal::Gpu::State::BindElementBuffer(dat.ibuff_handle);
 
 #ifdef JGFX_LL_DEBUG_OBJECTS_TRACKING
 			std::cout << "ref creation called: " << handle.handle << "\n";
@@ -461,6 +526,8 @@ namespace LLJGFX {
 
 				glDeleteVertexArrays(1, &vref_handle.handle);
 				glDeleteBuffers(1, &dat.ibuff_handle);
+				Internal::Gpu::State::ForgetVertexArray(vref_handle.handle);
+				Internal::Gpu::State::ForgetBuffer(dat.ibuff_handle);
 				Internal::vref_data.erase(vref_handle);
 			}
 			//Remove references from the bound vertex buffers
@@ -0,0 +1,43 @@
+#pragma once
+#include "LowLevel/Pipeline.h"
+
+namespace JGFX{
+	using LLJGFX::BlendFactor;
+	using LLJGFX::BlendOp;
+	using LLJGFX::CompareFunc;
+	using LLJGFX::CullMode;
+	using LLJGFX::StencilOp;
+	using LLJGFX::BlendState;
+	using LLJGFX::DepthState;
+	using LLJGFX::ScissorState;
+	using LLJGFX::StencilState;
+	using LLJGFX::PipelineDesc;
+
+	//Immutable, to change anything make a new one
+	class PipelineState{
+	private:
+		LLJGFX::PipelineState::Handle handle_ = { nullptr };
+	public:
+		inline const PipelineDesc& desc() const { return LLJGFX::PipelineState::GetDesc(handle_); }
+		inline LLJGFX::PipelineState::Handle handle() const { return handle_; }
+
+		inline PipelineState(const PipelineDesc& desc) { handle_ = LLJGFX::PipelineState::Make(desc); }
+
+		inline PipelineState& operator=(const PipelineState& cpy){
+			if(this == &cpy) return *this;
+			this->~PipelineState();
+			handle_ = LLJGFX::PipelineState::Make(cpy.desc());
+			return *this;
+		}
+		inline PipelineState(const PipelineState& cpy) { operator=(cpy); }
+
+		inline PipelineState& operator=(PipelineState&& cpy) noexcept {
+			this->~PipelineState();
+			std::swap(handle_, cpy.handle_);
+			return *this;
+		}
+		inline PipelineState(PipelineState&& cpy) noexcept { operator=(std::move(cpy)); }
+
+		inline ~PipelineState() { LLJGFX::PipelineState::Delete(handle_); handle_ = { nullptr }; }
+	};
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "LowLevel/Readback.h"
+#include "Texture.h"
+
+namespace JGFX{
+	//A pending read of pixels, see LLJGFX::Readback. It's released with the object
+	class Readback{
+	private:
+		LLJGFX::Readback::Handle handle_ = { nullptr };
+	public:
+		inline bool IsReady() const { return LLJGFX::Readback::IsReady(handle_); }
+		inline void Wait() const { LLJGFX::Readback::Wait(handle_); }
+
+		inline void Read(uint8* dest, uint32 row_stride = 0) const { LLJGFX::Readback::Read(handle_, dest, row_stride); }
+		//Reuses the storage of "dest" if it's big enough
+		inline void Read(std::string& dest) const {
+			dest.resize(LLJGFX::Readback::GetBinarySize(handle_));
+			Read((uint8*)dest.data());
+		}
+
+		inline pos2du16 size() const { return LLJGFX::Readback::GetSize(handle_); }
+		inline LLJGFX::Readback::Handle handle() const { return handle_; }
+
+		//NULL_TXT reads the window of the current context
+		inline Readback(Internal::TxtFnArg source, TextureRegion region = {})
+			{ handle_ = LLJGFX::Readback::Start(source, region); }
+
+		Readback(const Readback&) = delete;
+		Readback& operator=(const Readback&) = delete;
+
+		inline Readback& operator=(Readback&& cpy) noexcept {
+			this->~Readback();
+			std::swap(handle_, cpy.handle_);
+			return *this;
+		}
+		inline Readback(Readback&& cpy) noexcept { operator=(std::move(cpy)); }
+
+		inline ~Readback() { LLJGFX::Readback::Release(handle_); handle_ = { nullptr }; }
+	};
+}
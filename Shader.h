@@ -3,10 +3,16 @@
 
 namespace JGFX{
 	constexpr LLJGFX::ShaderProgram::Handle NULL_PRG = { nullptr };
+	template<typename T> using UniformHandle = LLJGFX::UniformHandle<T>;
+	using LLJGFX::ProgramReflection;
+	using LLJGFX::ShaderVariable;
+	using LLJGFX::ShaderSampler;
+	using LLJGFX::ShaderBlock;
 
 	class ShaderProgram {
 	private:
 		LLJGFX::ShaderProgram::Handle handle_ = { nullptr };
+	protected:
 		void BeforeModification() { if(handle_.data == nullptr) handle_ = LLJGFX::ShaderProgram::Make(); }
 	public:
 		inline LLJGFX::ShaderProgram::Handle handle() const { return handle_; }
@@ -16,7 +22,29 @@ namespace JGFX{
 			LLJGFX::ShaderProgram::Compile(handle_, vertex_src, fragment_src);
 		}
 
+		//See LLJGFX::ShaderProgram::CompileAsync()
+		void CompileAsync(const std::string& vertex_src, const std::string& fragment_src) {
+			BeforeModification();
+			LLJGFX::ShaderProgram::CompileAsync(handle_, vertex_src, fragment_src);
+		}
+		//The varyings are captured by JGFX::TransformFeedback::Capture() and JGFX::FeedbackPair::Step()
+		void CompileWithFeedback(const std::string& vertex_src, const std::string& fragment_src,
+		                         const std::vector<std::string>& varyings, bool interleaved = true) {
+			BeforeModification();
+			LLJGFX::ShaderProgram::CompileWithFeedback(handle_, vertex_src, fragment_src, varyings, interleaved);
+		}
+		inline bool IsReady() const { return handle_.data != nullptr && LLJGFX::ShaderProgram::IsReady(handle_); }
+		inline void Wait() const { if(handle_.data != nullptr) LLJGFX::ShaderProgram::Wait(handle_); }
+		//If the fallback is destroyed first, pending draws are skipped
+		inline void SetFallback(const ShaderProgram& fallback) {
+			BeforeModification();
+			LLJGFX::ShaderProgram::SetFallback(handle_, fallback.handle_);
+		}
+
 		inline void Bind() const { LLJGFX::ShaderProgram::Bind(handle_); }
+		inline const ProgramReflection& reflection() const { return LLJGFX::ShaderProgram::GetReflection(handle_); }
+		inline int32 GetSamplerUnit(const std::string& sampler) const { return LLJGFX::ShaderProgram::GetSamplerUnit(handle_, sampler); }
+		inline bool HasUniform(const std::string& uniform) const { return LLJGFX::ShaderProgram::HasUniform(handle_, uniform); }
 
 		template <typename T> inline ShaderProgram& SetUniform(const std::string& uniform, const T& value) const {
 			const_cast<ShaderProgram&>(*this).BeforeModification();
@@ -34,13 +62,32 @@ namespace JGFX{
 			return const_cast<ShaderProgram&>(*this);
 		}
 
+		template <typename T> inline UniformHandle<T> GetUniform(const std::string& uniform) const {
+			const_cast<ShaderProgram&>(*this).BeforeModification();
+			return LLJGFX::ShaderProgram::GetUniform<T>(handle_, uniform);
+		}
+		template <typename T> inline ShaderProgram& SetUniform(UniformHandle<T> uniform, const T& value) const {
+			LLJGFX::ShaderProgram::SetUniform(uniform, value);
+			return const_cast<ShaderProgram&>(*this);
+		}
+		template <typename T> inline ShaderProgram& SetUniform(UniformHandle<T> uniform, const T* value, size_t element_count) const {
+			LLJGFX::ShaderProgram::SetUniform(uniform, value, element_count);
+			return const_cast<ShaderProgram&>(*this);
+		}
+
 		inline ShaderProgram() = default;
 		inline ShaderProgram(const std::string& vertex, const std::string& fragment)
 			{ Compile(vertex, fragment); }
 
+		//Shares the GL program, nothing is compiled
 		inline ShaderProgram& operator=(const ShaderProgram& cpy) {
-			Compile(LLJGFX::ShaderProgram::GetAttachedVertexShader(cpy.handle_),
-			        LLJGFX::ShaderProgram::GetAttachedFragmentShader(cpy.handle_));
+			if(this == &cpy) return *this;
+			if(cpy.handle_.data == nullptr){
+				this->~ShaderProgram();
+				return *this;
+			}
+			BeforeModification();
+			LLJGFX::ShaderProgram::Share(handle_, cpy.handle_);
 			return *this;
 		}
 		inline ShaderProgram(const ShaderProgram& cpy) { operator=(cpy); }
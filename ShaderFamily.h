@@ -0,0 +1,37 @@
+#pragma once
+#include "LowLevel/ShaderFamily.h"
+
+namespace JGFX{
+	//Variants are handed out as LLJGFX::ShaderProgram handles, they can be passed to the draws directly
+	class ShaderFamily{
+	private:
+		LLJGFX::ShaderFamily::Handle handle_ = { nullptr };
+	public:
+		inline LLJGFX::ShaderFamily::Handle handle() const { return handle_; }
+
+		inline uint32 GetKeywordMask(const std::string& keyword) const
+			{ return LLJGFX::ShaderFamily::GetKeywordMask(handle_, keyword); }
+		inline void Precompile(const std::vector<uint32>& masks) const
+			{ LLJGFX::ShaderFamily::Precompile(handle_, masks); }
+		inline LLJGFX::ShaderProgram::Handle GetVariant(uint32 mask) const
+			{ return LLJGFX::ShaderFamily::GetVariant(handle_, mask); }
+		inline bool IsVariantReady(uint32 mask) const
+			{ return LLJGFX::ShaderFamily::IsVariantReady(handle_, mask); }
+
+		inline ShaderFamily(const std::string& vertex, const std::string& fragment, const std::vector<std::string>& keywords)
+			{ handle_ = LLJGFX::ShaderFamily::Make(vertex, fragment, keywords); }
+
+		//The variants are owned by the family
+		ShaderFamily(const ShaderFamily&) = delete;
+		ShaderFamily& operator=(const ShaderFamily&) = delete;
+
+		inline ShaderFamily& operator=(ShaderFamily&& cpy) noexcept {
+			this->~ShaderFamily();
+			std::swap(handle_, cpy.handle_);
+			return *this;
+		}
+		inline ShaderFamily(ShaderFamily&& cpy) noexcept { operator=(std::move(cpy)); }
+
+		inline ~ShaderFamily() { LLJGFX::ShaderFamily::Delete(handle_); handle_ = { nullptr }; }
+	};
+}
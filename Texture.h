@@ -3,6 +3,7 @@
 
 namespace JGFX {
 	constexpr LLJGFX::Texture::Handle NULL_TXT = { nullptr };
+	using TextureRegion = LLJGFX::TextureRegion;
 
 	class Texture {
 	private:
@@ -19,6 +20,15 @@ namespace JGFX {
 			LLJGFX::Texture::SetData(handle_, raw, src_size);
 			return *this;
 		}
+		//See LLJGFX::Texture::SetSubData()
+		inline Texture& SetSubData(TextureRegion region, const uint8 *raw, uint32 row_stride = 0) {
+			LLJGFX::Texture::SetSubData(handle_, region, raw, row_stride);
+			return *this;
+		}
+		inline Texture& SetSubData(TextureRegion region, const std::string &raw, uint32 row_stride = 0) {
+			LLJGFX::Texture::SetSubData(handle_, region, raw, row_stride);
+			return *this;
+		}
 		inline Texture& LoadCompressed(const std::string &compr_src) {
 			this->BeforeModification();
 			LLJGFX::Texture::LoadCompressed(handle_, compr_src);
@@ -29,9 +39,15 @@ namespace JGFX {
 			LLJGFX::Texture::LoadFromFile(handle_, path);
 			return *this;
 		}
-		inline Texture& Resize(pos2du16 new_size) {
+		//Nothing is uploaded, "clear" zeroes the new storage on the GPU
+		inline Texture& Resize(pos2du16 new_size, bool clear = true) {
 			BeforeModification();
-			LLJGFX::Texture::Resize(handle_, new_size);
+			LLJGFX::Texture::Resize(handle_, new_size, clear);
+			return *this;
+		}
+		inline Texture& Clear() {
+			BeforeModification();
+			LLJGFX::Texture::Clear(handle_);
 			return *this;
 		}
 		inline Texture& Bind() {
@@ -59,8 +75,21 @@ namespace JGFX {
 			return *this;
 		}
 
+		//Scaled if the regions differ in size, see LLJGFX::Texture::Blit()
+		inline Texture& Blit(const Texture& from, TextureRegion to_region = {}, TextureRegion from_region = {}, bool linear = false) {
+			BeforeModification();
+			LLJGFX::Texture::Blit(handle_, to_region, from.handle_, from_region, linear);
+			return *this;
+		}
+		inline Texture& CopyRegion(const Texture& from, TextureRegion region) {
+			BeforeModification();
+			LLJGFX::Texture::CopyRegion(handle_, from.handle_, region);
+			return *this;
+		}
+
 		//inline Texture& operator<<(const LLJGFX::TemporaryRT& target);
 
+		//Stalls until the GPU is done with the texture, JGFX::Readback doesn't
 		inline std::string Dump() const { return LLJGFX::Texture::GetData(handle_); }
 		inline pos2du16 size() const { return LLJGFX::Texture::GetSize(handle_); }
 		inline LLJGFX::Texture::Handle handle() const { return handle_; }
@@ -102,9 +131,12 @@ namespace JGFX {
 			return *this;
 		}
 
+		//The copy is made on the GPU(see LLJGFX::Texture::Copy())
 		inline Texture &operator=(const Texture &cpy) {
-			SetData(cpy.Dump(), cpy.size());
-			SetModes(cpy.filtering(), cpy.wrapping());
+			if(this == &cpy) return *this;
+			if(cpy.handle_.data == nullptr) { this->~Texture(); return *this; }
+			BeforeModification();
+			LLJGFX::Texture::Copy(handle_, cpy.handle_);
 			return *this;
 		}
 		inline Texture(const Texture &cpy) { operator=(cpy); }
@@ -114,7 +146,7 @@ namespace JGFX {
 			std::swap(handle_, cpy.handle_);
 			return *this;
 		}
-		inline Texture(Texture &&cpy) noexcept { operator=(cpy); }
+		inline Texture(Texture &&cpy) noexcept { operator=(std::move(cpy)); }
 
 		inline ~Texture() {
 			LLJGFX::Texture::Delete(handle_);
@@ -132,4 +164,8 @@ namespace JGFX {
 	}
 
 	inline void BindFramebuffer(Internal::TxtFnArg fb) { LLJGFX::BindFramebuffer(fb); }
+	//NULL_TXT as "to" is the window of the current context, e.g. for presenting an offscreen target
+	inline void Blit(Internal::TxtFnArg to, Internal::TxtFnArg from, TextureRegion to_region = {}, TextureRegion from_region = {},
+	                 bool linear = false)
+		{ LLJGFX::Texture::Blit(to, to_region, from, from_region, linear); }
 }
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+#include "LowLevel/TextureUpload.h"
+#include "Texture.h"
+
+namespace JGFX{
+	using UploadRingStats = LLJGFX::UploadRingStats;
+
+	//Streams pixels into textures without blocking on the driver copy, see LLJGFX::UploadRing
+	class UploadRing{
+	private:
+		LLJGFX::UploadRing::Handle handle_ = { nullptr };
+	public:
+		inline UploadRing& Upload(const Texture& target, TextureRegion region, const uint8* data, uint32 row_stride = 0)
+			{ LLJGFX::UploadRing::Upload(handle_, target.handle(), region, data, row_stride); return *this; }
+		inline UploadRing& Upload(const Texture& target, TextureRegion region, const std::string& data, uint32 row_stride = 0)
+			{ return Upload(target, region, (const uint8*)data.data(), row_stride); }
+
+		//For writing the pixels straight into the mapped memory(e.g. decoding a frame into it)
+		inline uint8* Begin(const Texture& target, TextureRegion region = {})
+			{ return LLJGFX::UploadRing::Begin(handle_, target.handle(), region); }
+		inline void End() { LLJGFX::UploadRing::End(handle_); }
+
+		inline size_t capacity() const { return LLJGFX::UploadRing::GetCapacity(handle_); }
+		inline UploadRingStats stats() const { return LLJGFX::UploadRing::GetStats(handle_); }
+		inline LLJGFX::UploadRing::Handle handle() const { return handle_; }
+
+		inline explicit UploadRing(size_t capacity) { handle_ = LLJGFX::UploadRing::Make(capacity); }
+
+		UploadRing(const UploadRing&) = delete;
+		UploadRing& operator=(const UploadRing&) = delete;
+
+		inline UploadRing& operator=(UploadRing&& cpy) noexcept {
+			this->~UploadRing();
+			std::swap(handle_, cpy.handle_);
+			return *this;
+		}
+		inline UploadRing(UploadRing&& cpy) noexcept { operator=(std::move(cpy)); }
+
+		inline ~UploadRing() { LLJGFX::UploadRing::Delete(handle_); handle_ = { nullptr }; }
+	};
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "LowLevel/TransformFeedback.h"
+#include "Shader.h"
+
+namespace JGFX{
+	namespace TransformFeedback{
+		using namespace LLJGFX::TransformFeedback;
+	}
+
+	//Ping-pong pair of vertex buffers for a simulation, that stays on the GPU
+	class FeedbackPair{
+	private:
+		LLJGFX::FeedbackPair::Handle handle_ = { nullptr };
+	public:
+		inline FeedbackPair& Step(const ShaderProgram& program, bool discard_rasterizer = true)
+			{ LLJGFX::FeedbackPair::Step(handle_, program.handle(), discard_rasterizer); return *this; }
+		inline FeedbackPair& Attach(LLJGFX::VRef::Handle vref)
+			{ LLJGFX::FeedbackPair::Attach(handle_, vref); return *this; }
+
+		inline LLJGFX::VBuff::Handle front() const { return LLJGFX::FeedbackPair::GetFront(handle_); }
+		inline uint32 vertex_count() const { return LLJGFX::FeedbackPair::GetVertexCount(handle_); }
+		inline LLJGFX::FeedbackPair::Handle handle() const { return handle_; }
+
+		template<typename T> inline FeedbackPair(const std::vector<T>& data, const VertexLayout& layout)
+			{ handle_ = LLJGFX::FeedbackPair::Make(data, layout); }
+		template<typename T> inline FeedbackPair(const T* data, size_t size, const VertexLayout& layout)
+			{ handle_ = LLJGFX::FeedbackPair::Make(data, size, layout); }
+
+		FeedbackPair(const FeedbackPair&) = delete;
+		FeedbackPair& operator=(const FeedbackPair&) = delete;
+
+		inline FeedbackPair& operator=(FeedbackPair&& cpy) noexcept {
+			this->~FeedbackPair();
+			std::swap(handle_, cpy.handle_);
+			return *this;
+		}
+		inline FeedbackPair(FeedbackPair&& cpy) noexcept { operator=(std::move(cpy)); }
+
+		inline ~FeedbackPair() { LLJGFX::FeedbackPair::Delete(handle_); handle_ = { nullptr }; }
+	};
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "LowLevel/UniformBuffer.h"
+
+namespace JGFX{
+	using LLJGFX::BlockLayout;
+	using LLJGFX::UniformBlockLayout;
+	using LLJGFX::Std140Layout;
+	using LLJGFX::Std430Layout;
+
+	//"Layout" is a Std140Layout<...> with the member types of the block
+	template<typename Layout> class UniformBuffer{
+	private:
+		LLJGFX::UniformBuffer::Handle handle_ = { nullptr };
+	public:
+		template<typename... Ts> inline UniformBuffer& Set(const Ts&... values)
+			{ LLJGFX::UniformBuffer::SetBlock<Layout>(handle_, values...); return *this; }
+		template<size_t I> inline UniformBuffer& SetMember(const typename Layout::template MemberType<I>& value)
+			{ LLJGFX::UniformBuffer::SetMember<Layout, I>(handle_, value); return *this; }
+
+		inline uint32 binding_point() const { return LLJGFX::UniformBuffer::GetBindingPoint(handle_); }
+		inline LLJGFX::UniformBuffer::Handle handle() const { return handle_; }
+
+		inline UniformBuffer(const std::string& block_name) { handle_ = LLJGFX::UniformBuffer::Make(block_name, Layout::size); }
+
+		//A block name can have only one buffer
+		UniformBuffer(const UniformBuffer&) = delete;
+		UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+		inline UniformBuffer& operator=(UniformBuffer&& cpy) noexcept {
+			this->~UniformBuffer();
+			std::swap(handle_, cpy.handle_);
+			return *this;
+		}
+		inline UniformBuffer(UniformBuffer&& cpy) noexcept { operator=(std::move(cpy)); }
+
+		inline ~UniformBuffer() { LLJGFX::UniformBuffer::Delete(handle_); handle_ = { nullptr }; }
+	};
+}